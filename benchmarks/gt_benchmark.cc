@@ -0,0 +1,334 @@
+// This benchmark measures the per-sample cost of GT decoding on
+// a synthetic VCF file held in memory. Each of the genotype APIs
+// of VCF_scanner is timed separately, as well as decoding of every
+// hundredth sample selected by select_samples() or looked up with
+// parse_genotype_of(). Decoding of the AD and PL integer lists, of
+// the GP dosages, and of rare variants is timed on separate files.
+//
+// Usage: gt_benchmark [NUMBER_OF_SAMPLES [NUMBER_OF_LINES]]
+
+#include <vcf_scanner/vcf_scanner.hh>
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+// Generates a file whose genotype fields are chosen at random
+// from 'values'.
+static std::string make_vcf(unsigned number_of_samples,
+        unsigned number_of_lines, const char* format,
+        const std::vector<const char*>& values)
+{
+    std::string vcf = "##fileformat=VCFv4.2\n"
+                      "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT";
+    for (unsigned i = 0; i < number_of_samples; ++i) {
+        vcf += "\tS" + std::to_string(i);
+    }
+
+    uint32_t random = 12345;
+
+    for (unsigned line = 1; line <= number_of_lines; ++line) {
+        vcf += "\n1\t" + std::to_string(line) + "\t.\tA\tG\t.\t.\t.\t";
+        vcf += format;
+        for (unsigned i = 0; i < number_of_samples; ++i) {
+            random = random * 1103515245U + 12345U;
+            vcf += '\t';
+            vcf += values[(random >> 16) % values.size()];
+        }
+    }
+    vcf += '\n';
+    return vcf;
+}
+
+static bool parse(VCF_scanner& vcf_scanner, VCF_parsing_event pe)
+{
+    if (pe == VCF_parsing_event::need_more_data) {
+        pe = vcf_scanner.feed(nullptr, 0);
+    }
+    if (pe == VCF_parsing_event::error) {
+        fprintf(stderr, "Line %u: %s\n", vcf_scanner.get_line_number(),
+                vcf_scanner.get_error().c_str());
+        return false;
+    }
+    return true;
+}
+
+// Parses the VCF data, which is fed in one buffer, calling 'parse_line()'
+// after the FORMAT field of each line. Returns the time in nanoseconds
+// or a negative value in case of an error.
+static double time_pass(const std::string& vcf,
+        const std::function<bool(VCF_scanner&)>& parse_line,
+        const std::vector<unsigned>& selected_samples)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    VCF_scanner vcf_scanner;
+    VCF_header header;
+
+    VCF_parsing_event pe = vcf_scanner.parse_header(&header);
+    if (pe == VCF_parsing_event::need_more_data) {
+        pe = vcf_scanner.feed(vcf.data(), (ssize_t) vcf.length());
+    }
+    if (pe != VCF_parsing_event::ok) {
+        fprintf(stderr, "Cannot parse the header\n");
+        return -1;
+    }
+    if (!selected_samples.empty()) {
+        vcf_scanner.select_samples(selected_samples);
+    }
+
+    while (!vcf_scanner.at_eof()) {
+        if (!parse(vcf_scanner, vcf_scanner.parse_genotype_format()) ||
+                !parse_line(vcf_scanner) ||
+                !parse(vcf_scanner, vcf_scanner.clear_line())) {
+            return -1;
+        }
+    }
+
+    const std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start_time;
+
+    return elapsed.count();
+}
+
+// Prints the best time per sample out of several passes. The time
+// is divided by the total number of samples even if only some of
+// them are selected.
+static void run(const char* name, const std::string& vcf,
+        unsigned number_of_samples, unsigned number_of_lines,
+        const std::function<bool(VCF_scanner&)>& parse_line,
+        const std::vector<unsigned>& selected_samples = {})
+{
+    static const int number_of_passes = 5;
+
+    double best_time = 0;
+
+    for (int pass = 0; pass < number_of_passes; ++pass) {
+        const double time = time_pass(vcf, parse_line, selected_samples);
+        if (time < 0) {
+            return;
+        }
+        if (pass == 0 || time < best_time) {
+            best_time = time;
+        }
+    }
+
+    printf("%-16s %8.2f ns/sample\n", name,
+            best_time / ((double) number_of_samples * number_of_lines));
+}
+
+int main(int argc, const char* argv[])
+{
+    const unsigned number_of_samples =
+            argc > 1 ? (unsigned) atoi(argv[1]) : 2000;
+    const unsigned number_of_lines = argc > 2 ? (unsigned) atoi(argv[2]) : 2000;
+
+    // Typical distribution of calls in a population callset.
+    const std::string vcf = make_vcf(number_of_samples, number_of_lines, "GT",
+            {"0/0", "0/0", "0/0", "0/0", "0/0", "0/0", "0|0", "0/1", "0|1",
+                    "1/1", "./.", "0/0"});
+
+    size_t checksum = 0;
+
+    run("parse_genotype", vcf, number_of_samples, number_of_lines,
+            [&](VCF_scanner& vcf_scanner) {
+                if (!vcf_scanner.capture_gt()) {
+                    return false;
+                }
+                while (vcf_scanner.genotype_available()) {
+                    if (!parse(vcf_scanner, vcf_scanner.parse_genotype())) {
+                        return false;
+                    }
+                    checksum += vcf_scanner.get_gt().size();
+                }
+                return true;
+            });
+
+    VCF_genotype_matrix matrix(number_of_samples);
+
+    run("parse_gt_row", vcf, number_of_samples, number_of_lines,
+            [&](VCF_scanner& vcf_scanner) {
+                matrix.clear();
+                return parse(vcf_scanner, vcf_scanner.parse_gt_row(&matrix));
+            });
+
+    std::vector<uint8_t> packed((number_of_samples + 3) / 4);
+
+    run("packed_gt_row", vcf, number_of_samples, number_of_lines,
+            [&](VCF_scanner& vcf_scanner) {
+                return parse(vcf_scanner,
+                        vcf_scanner.parse_packed_gt_row(packed.data()));
+            });
+
+    VCF_allele_counts counts;
+
+    run("count_alleles", vcf, number_of_samples, number_of_lines,
+            [&](VCF_scanner& vcf_scanner) {
+                if (!parse(vcf_scanner, vcf_scanner.count_alleles(&counts))) {
+                    return false;
+                }
+                checksum += counts.number_of_called_alleles;
+                return true;
+            });
+
+    // Every hundredth sample.
+    std::vector<unsigned> selected_samples;
+    for (unsigned i = 0; i < number_of_samples; i += 100) {
+        selected_samples.push_back(i);
+    }
+    VCF_genotype_matrix selected_matrix(
+            (unsigned) selected_samples.size());
+
+    run("selected_gt_row", vcf, number_of_samples, number_of_lines,
+            [&](VCF_scanner& vcf_scanner) {
+                selected_matrix.clear();
+                return parse(vcf_scanner,
+                        vcf_scanner.parse_gt_row(&selected_matrix));
+            },
+            selected_samples);
+
+    run("genotype_of", vcf, number_of_samples, number_of_lines,
+            [&](VCF_scanner& vcf_scanner) {
+                if (!vcf_scanner.capture_gt() ||
+                        !parse(vcf_scanner, vcf_scanner.index_genotypes())) {
+                    return false;
+                }
+                for (unsigned sample : selected_samples) {
+                    if (!parse(vcf_scanner,
+                                vcf_scanner.parse_genotype_of(sample))) {
+                        return false;
+                    }
+                    checksum += vcf_scanner.get_gt().size();
+                }
+                return true;
+            });
+
+    const std::string lists_vcf = make_vcf(number_of_samples,
+            number_of_lines, "GT:AD:PL",
+            {"0/0:12,0:0,36,420", "0/0:31,0:0,90,1350", "0/1:5,7:120,0,150",
+                    "0/1:14,11:255,0,311", "1/1:0,9:300,27,0",
+                    "0/0:8,1:0,18,227", "./.:.:."});
+
+    std::vector<int> ad, pl;
+
+    run("ad_pl_captures", lists_vcf, number_of_samples, number_of_lines,
+            [&](VCF_scanner& vcf_scanner) {
+                if (!vcf_scanner.capture_ints("AD", &ad) ||
+                        !vcf_scanner.capture_ints("PL", &pl)) {
+                    return false;
+                }
+                while (vcf_scanner.genotype_available()) {
+                    if (!parse(vcf_scanner, vcf_scanner.parse_genotype())) {
+                        return false;
+                    }
+                    checksum += ad.size() + pl.size();
+                }
+                return true;
+            });
+
+    run("pl_capture", lists_vcf, number_of_samples, number_of_lines,
+            [&](VCF_scanner& vcf_scanner) {
+                if (!vcf_scanner.capture_ints("PL", &pl)) {
+                    return false;
+                }
+                while (vcf_scanner.genotype_available()) {
+                    if (!parse(vcf_scanner, vcf_scanner.parse_genotype())) {
+                        return false;
+                    }
+                    checksum += pl.size();
+                }
+                return true;
+            });
+
+    const std::string gp_vcf = make_vcf(number_of_samples, number_of_lines,
+            "GP",
+            {"0.998,0.002,0", "1,0,0", "0.012,0.975,0.013", "0.95,0.05,0",
+                    "0,0.001,0.999", "0.873,0.126,0.001", "."});
+
+    std::vector<float> gp;
+
+    run("gp_capture", gp_vcf, number_of_samples, number_of_lines,
+            [&](VCF_scanner& vcf_scanner) {
+                if (!vcf_scanner.capture_floats("GP", &gp)) {
+                    return false;
+                }
+                while (vcf_scanner.genotype_available()) {
+                    if (!parse(vcf_scanner, vcf_scanner.parse_genotype())) {
+                        return false;
+                    }
+                    checksum += gp.size();
+                }
+                return true;
+            });
+
+    std::vector<float> dosages(number_of_samples * 3);
+
+    run("gp_float_row", gp_vcf, number_of_samples, number_of_lines,
+            [&](VCF_scanner& vcf_scanner) {
+                return parse(vcf_scanner,
+                        vcf_scanner.parse_dosage_row("GP", dosages.data(), 3));
+            });
+
+    std::vector<uint16_t> fixed_dosages(number_of_samples * 3);
+
+    run("gp_fixed_row", gp_vcf, number_of_samples, number_of_lines,
+            [&](VCF_scanner& vcf_scanner) {
+                return parse(vcf_scanner,
+                        vcf_scanner.parse_dosage_row(
+                                "GP", fixed_dosages.data(), 3));
+            });
+
+    // About one non-reference call per thousand samples.
+    std::vector<const char*> rare_genotypes(1000, "0/0");
+    rare_genotypes[0] = "0/1";
+    const std::string rare_vcf = make_vcf(
+            number_of_samples, number_of_lines, "GT", rare_genotypes);
+
+    run("rare_genotype", rare_vcf, number_of_samples, number_of_lines,
+            [&](VCF_scanner& vcf_scanner) {
+                if (!vcf_scanner.capture_gt()) {
+                    return false;
+                }
+                while (vcf_scanner.genotype_available()) {
+                    if (!parse(vcf_scanner, vcf_scanner.parse_genotype())) {
+                        return false;
+                    }
+                    checksum += vcf_scanner.get_gt().size();
+                }
+                return true;
+            });
+
+    run("rare_gt_row", rare_vcf, number_of_samples, number_of_lines,
+            [&](VCF_scanner& vcf_scanner) {
+                matrix.clear();
+                return parse(vcf_scanner, vcf_scanner.parse_gt_row(&matrix));
+            });
+
+    VCF_sparse_gt_row sparse_row;
+
+    run("rare_sparse_row", rare_vcf, number_of_samples, number_of_lines,
+            [&](VCF_scanner& vcf_scanner) {
+                if (!parse(vcf_scanner,
+                            vcf_scanner.parse_sparse_gt_row(&sparse_row))) {
+                    return false;
+                }
+                checksum += sparse_row.samples.size();
+                return true;
+            });
+
+    // Parsing stops at the first carrier.
+    run("rare_carrier", rare_vcf, number_of_samples, number_of_lines,
+            [&](VCF_scanner& vcf_scanner) {
+                bool has_carrier;
+                if (!parse(vcf_scanner,
+                            vcf_scanner.evaluate_gt_predicate(
+                                    {VCF_gt_predicate::carrier, 1},
+                                    &has_carrier))) {
+                    return false;
+                }
+                checksum += has_carrier;
+                return true;
+            });
+
+    return checksum == 0;
+}
@@ -0,0 +1,180 @@
+// This benchmark measures the per-line cost of parsing the mandatory
+// fields of sites-only data lines held in memory. The chain of
+// 'parse_loc()'...'parse_info()' calls is compared with
+// 'parse_record()', which defers the decoding of each field until
+// it is accessed, and reading QUAL line by line is compared with
+// reading it from the columns filled by 'parse_batch()'.
+//
+// Usage: record_benchmark [NUMBER_OF_LINES]
+
+#include <vcf_scanner/vcf_scanner.hh>
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+static std::string make_vcf(unsigned number_of_lines)
+{
+    std::string vcf = "##fileformat=VCFv4.2\n"
+                      "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO";
+
+    // Lines of about 230 bytes with an INFO field
+    // typical of a variant calling pipeline.
+    for (unsigned line = 1; line <= number_of_lines; ++line) {
+        vcf += "\nchr1\t" + std::to_string(line) + "\trs" +
+                std::to_string(line) + "\tA\tG,T\t" +
+                std::to_string(line % 100) +
+                "\tPASS\tAC=1,2;AN=1000;AF=0.001,0.002;DP=12345;MQ=60;"
+                "QD=12.5;FS=0.1;SOR=0.7;ReadPosRankSum=0.1;"
+                "ClippingRankSum=0;BaseQRankSum=1.2;VQSLOD=5.5;culprit=MQ";
+    }
+    vcf += '\n';
+    return vcf;
+}
+
+static bool parse(VCF_scanner& vcf_scanner, VCF_parsing_event pe)
+{
+    if (pe == VCF_parsing_event::need_more_data) {
+        pe = vcf_scanner.feed(nullptr, 0);
+    }
+    if (pe == VCF_parsing_event::error) {
+        fprintf(stderr, "Line %u: %s\n", vcf_scanner.get_line_number(),
+                vcf_scanner.get_error().c_str());
+        return false;
+    }
+    return true;
+}
+
+// Parses the VCF data, which is fed in one buffer, by calling
+// 'parse_lines()' until the end of the data. The function must parse
+// one or more lines including their 'clear_line()' calls. Returns the
+// time in nanoseconds or a negative value in case of an error.
+static double time_pass(const std::string& vcf,
+        const std::function<bool(VCF_scanner&)>& parse_lines)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    VCF_scanner vcf_scanner;
+    VCF_header header;
+
+    VCF_parsing_event pe = vcf_scanner.parse_header(&header);
+    if (pe == VCF_parsing_event::need_more_data) {
+        pe = vcf_scanner.feed(vcf.data(), (ssize_t) vcf.length());
+    }
+    if (pe != VCF_parsing_event::ok) {
+        fprintf(stderr, "Cannot parse the header\n");
+        return -1;
+    }
+
+    while (!vcf_scanner.at_eof()) {
+        if (!parse_lines(vcf_scanner)) {
+            return -1;
+        }
+    }
+
+    const std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start_time;
+
+    return elapsed.count();
+}
+
+// Prints the best time per line out of several passes.
+static void run(const char* name, const std::string& vcf,
+        unsigned number_of_lines,
+        const std::function<bool(VCF_scanner&)>& parse_lines)
+{
+    static const int number_of_passes = 5;
+
+    double best_time = 0;
+
+    for (int pass = 0; pass < number_of_passes; ++pass) {
+        const double time = time_pass(vcf, parse_lines);
+        if (time < 0) {
+            return;
+        }
+        if (pass == 0 || time < best_time) {
+            best_time = time;
+        }
+    }
+
+    printf("%-16s %8.1f ns/line\n", name, best_time / number_of_lines);
+}
+
+int main(int argc, const char* argv[])
+{
+    const unsigned number_of_lines =
+            argc > 1 ? (unsigned) atoi(argv[1]) : 500000;
+
+    const std::string vcf = make_vcf(number_of_lines);
+
+    size_t checksum = 0;
+
+    std::string chrom;
+    unsigned pos;
+    std::vector<std::string> ids;
+    std::string ref;
+    std::vector<std::string> alts;
+    std::string quality;
+    std::vector<std::string> filters;
+
+    // All eight fields are extracted in both cases.
+    run("field_chain", vcf, number_of_lines, [&](VCF_scanner& vcf_scanner) {
+        if (!parse(vcf_scanner, vcf_scanner.parse_loc(&chrom, &pos)) ||
+                !parse(vcf_scanner, vcf_scanner.parse_ids(&ids)) ||
+                !parse(vcf_scanner, vcf_scanner.parse_alleles(&ref, &alts)) ||
+                !parse(vcf_scanner, vcf_scanner.parse_quality(&quality)) ||
+                !parse(vcf_scanner, vcf_scanner.parse_filters(&filters)) ||
+                !parse(vcf_scanner, vcf_scanner.parse_info())) {
+            return false;
+        }
+        checksum += alts.size() + vcf_scanner.get_info().size();
+        return parse(vcf_scanner, vcf_scanner.clear_line());
+    });
+
+    VCF_record record;
+
+    run("parse_record", vcf, number_of_lines, [&](VCF_scanner& vcf_scanner) {
+        if (!parse(vcf_scanner, vcf_scanner.parse_record(&record)) ||
+                !record.get_pos(&pos)) {
+            return false;
+        }
+        checksum += record.get_chrom().length() + record.get_ids().size() +
+                record.get_ref().length() + record.get_alts().size() +
+                record.get_quality().length() + record.get_filters().size() +
+                record.get_info().size();
+        return parse(vcf_scanner, vcf_scanner.clear_line());
+    });
+
+    unsigned contig_id;
+    float quality_value;
+    double quality_sum = 0;
+
+    run("quality_chain", vcf, number_of_lines, [&](VCF_scanner& vcf_scanner) {
+        if (!parse(vcf_scanner, vcf_scanner.parse_loc(&contig_id, &pos)) ||
+                !parse(vcf_scanner, vcf_scanner.parse_ids(&ids)) ||
+                !parse(vcf_scanner, vcf_scanner.parse_alleles(&ref, &alts)) ||
+                !parse(vcf_scanner,
+                        vcf_scanner.parse_quality(&quality_value))) {
+            return false;
+        }
+        quality_sum += quality_value;
+        return parse(vcf_scanner, vcf_scanner.clear_line());
+    });
+
+    VCF_record_batch batch;
+
+    // 'clear_line()' is not called for the lines of a batch.
+    run("parse_batch", vcf, number_of_lines, [&](VCF_scanner& vcf_scanner) {
+        if (!parse(vcf_scanner, vcf_scanner.parse_batch(&batch, 1024))) {
+            return false;
+        }
+        for (float value : batch.get_qualities()) {
+            quality_sum += value;
+        }
+        return true;
+    });
+
+    checksum += quality_sum > 0;
+
+    return checksum == 0;
+}
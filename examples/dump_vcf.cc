@@ -1,31 +1,71 @@
 // This example parses the specified VCF file and prints the extracted data
 // to the standard output stream.
 
-#include <vcf_scanner/vcf_scanner.hh>
+#include <vcf_scanner/vcf_parallel.hh>
 
 #include <iostream>
+#include <memory>
+
+static void print_header(const VCF_header& header)
+{
+    std::cout << "##fileformat=" << header.get_file_format_version()
+              << std::endl;
+
+    for (const auto& kv : header.get_meta_info()) {
+        for (const auto& v : kv.second) {
+            std::cout << "##" << kv.first << '=' << v << std::endl;
+        }
+    }
+
+    std::cout << "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT";
+    for (const auto& v : header.get_sample_ids()) {
+        std::cout << '\t' << v;
+    }
+    std::cout << std::endl;
+}
 
 int main(int argc, const char* argv[])
 {
-    if (argc != 2) {
-        fprintf(stderr, "Usage %s VCF_FILE\n", *argv);
-        return 2;
+    // With '--shard I/N', only the I-th of N line-aligned parts of
+    // the data lines is printed. The header is printed by shard 0.
+    // The outputs of all shards concatenated in order are identical
+    // to the output without this option.
+    unsigned shard_index = 0, number_of_shards = 0;
+
+    if (argc == 4 && strcmp(argv[1], "--shard") == 0) {
+        if (sscanf(argv[2], "%u/%u", &shard_index, &number_of_shards) != 2 ||
+                shard_index >= number_of_shards) {
+            fprintf(stderr, "Invalid shard specification: %s\n", argv[2]);
+            return 2;
+        }
+        argc -= 2;
+        argv += 2;
     }
 
-    FILE* input = fopen(argv[1], "rb");
-    if (input == nullptr) {
-        perror(argv[1]);
-        return 1;
+    if (argc != 2) {
+        fprintf(stderr, "Usage %s [--shard I/N] VCF_FILE\n", *argv);
+        return 2;
     }
 
     static std::array<char, 1024 * 1024> buffer;
 
     VCF_scanner vcf_scanner;
 
+    FILE* input = nullptr;
+    std::unique_ptr<VCF_file_input> file_input;
+    std::unique_ptr<VCF_range_feeder> range_feeder;
+
+    auto read_and_feed = [&]() -> VCF_parsing_event {
+        if (range_feeder) {
+            return range_feeder->read_and_feed(vcf_scanner);
+        }
+        return vcf_scanner.feed(
+                buffer.data(), fread(buffer.data(), 1, buffer.size(), input));
+    };
+
     auto parse_to_completion = [&](VCF_parsing_event pe) {
         while (pe == VCF_parsing_event::need_more_data) {
-            pe = vcf_scanner.feed(buffer.data(),
-                    fread(buffer.data(), 1, buffer.size(), input));
+            pe = read_and_feed();
         }
 
         if (pe == VCF_parsing_event::error) {
@@ -44,24 +84,44 @@ int main(int argc, const char* argv[])
 
     VCF_header header;
 
-    if (!parse_to_completion(vcf_scanner.parse_header(&header))) {
-        return 1;
-    }
+    if (number_of_shards == 0) {
+        input = fopen(argv[1], "rb");
+        if (input == nullptr) {
+            perror(argv[1]);
+            return 1;
+        }
 
-    std::cout << "##fileformat=" << header.get_file_format_version()
-              << std::endl;
+        if (!parse_to_completion(vcf_scanner.parse_header(&header))) {
+            return 1;
+        }
+    } else {
+        file_input.reset(new VCF_file_input(argv[1]));
+        if (!file_input->is_open()) {
+            std::cerr << file_input->get_error() << std::endl;
+            return 1;
+        }
 
-    for (const auto& kv : header.get_meta_info()) {
-        for (const auto& v : kv.second) {
-            std::cout << "##" << kv.first << '=' << v << std::endl;
+        VCF_shard_planner shard_planner(*file_input);
+        std::vector<VCF_byte_range> shards;
+
+        if (shard_planner.parse_header(&header) != VCF_parsing_event::ok ||
+                !shard_planner.plan_shards(number_of_shards, &shards)) {
+            std::cerr << shard_planner.get_error() << std::endl;
+            return 1;
+        }
+
+        range_feeder.reset(
+                new VCF_range_feeder(*file_input, shards[shard_index]));
+
+        if (!parse_to_completion(vcf_scanner.start_at_data_line(header))) {
+            std::cerr << range_feeder->get_error() << std::endl;
+            return 1;
         }
     }
 
-    std::cout << "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT";
-    for (const auto& v : header.get_sample_ids()) {
-        std::cout << '\t' << v;
+    if (shard_index == 0) {
+        print_header(header);
     }
-    std::cout << std::endl;
 
     std::string chrom;
     unsigned pos;
@@ -0,0 +1,64 @@
+// This header contains implementation details.
+#ifndef VCF_SCANNER__HH
+#    error this file is not meant to be included directly
+#endif
+
+// Assigns consecutive integer IDs to the names that it encounters.
+// Used for the values that repeat from line to line, like CHROM.
+class VCF_dictionary
+{
+public:
+    // Returns the ID of the name adding the name if it is new.
+    unsigned get_id(const char* name, size_t len)
+    {
+        // The same name usually occurs on many lines in a row,
+        // in which case the hash table is not consulted.
+        if (last_id < names.size()) {
+            const std::string& last_name = names[last_id];
+            if (last_name.length() == len &&
+                    memcmp(last_name.data(), name, len) == 0) {
+                return last_id;
+            }
+        }
+
+        // The key buffer is reused to avoid allocating memory
+        // for the lookups of known names.
+        lookup_key.assign(name, len);
+
+        const auto it = ids.find(lookup_key);
+        if (it != ids.end()) {
+            return last_id = it->second;
+        }
+
+        last_id = (unsigned) names.size();
+        ids.emplace(lookup_key, last_id);
+        names.push_back(lookup_key);
+        return last_id;
+    }
+
+    // Returns the ID of the name or UINT_MAX if the name
+    // has not been encountered.
+    unsigned find_id(const std::string& name) const
+    {
+        const auto it = ids.find(name);
+        return it != ids.end() ? it->second : UINT_MAX;
+    }
+
+    const std::vector<std::string>& get_names() const
+    {
+        return names;
+    }
+
+    void clear()
+    {
+        names.clear();
+        ids.clear();
+        last_id = 0;
+    }
+
+private:
+    std::vector<std::string> names;
+    std::unordered_map<std::string, unsigned> ids;
+    unsigned last_id = 0;
+    std::string lookup_key;
+};
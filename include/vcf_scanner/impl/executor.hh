@@ -0,0 +1,339 @@
+// This header contains implementation details.
+#ifndef VCF_PARALLEL__HH
+#    error this file is not meant to be included directly
+#endif
+
+class VCF_thread_pool_impl : public VCF_executor
+{
+protected:
+    explicit VCF_thread_pool_impl(unsigned number_of_threads)
+    {
+        if (number_of_threads == 0) {
+            number_of_threads = std::thread::hardware_concurrency();
+            if (number_of_threads == 0) {
+                number_of_threads = 1;
+            }
+        }
+
+        node_workers.resize(1);
+        for (unsigned i = 0; i < number_of_threads; ++i) {
+            add_worker_queue(0);
+        }
+        start_workers(nullptr);
+    }
+
+    VCF_thread_pool_impl(
+            const VCF_numa_topology_impl& topology, unsigned threads_per_node)
+    {
+        const unsigned number_of_nodes = topology.get_number_of_nodes_impl();
+
+        node_workers.resize(number_of_nodes);
+        for (unsigned node = 0; node < number_of_nodes; ++node) {
+            unsigned number_of_threads = threads_per_node;
+            if (number_of_threads == 0) {
+                number_of_threads =
+                        (unsigned) topology.get_node_cpus_impl(node).size();
+                if (number_of_threads == 0) {
+                    number_of_threads = 1;
+                }
+            }
+            for (unsigned i = 0; i < number_of_threads; ++i) {
+                add_worker_queue(node);
+            }
+        }
+        start_workers(&topology);
+    }
+
+    void add_worker_queue(unsigned node)
+    {
+        node_workers[node].push_back((unsigned) queues.size());
+        queues.emplace_back(new Worker_queue);
+        queues.back()->node = node;
+    }
+
+    void start_workers(const VCF_numa_topology_impl* topology)
+    {
+        const unsigned number_of_workers = (unsigned) queues.size();
+
+        // Victims are visited in the order of proximity:
+        // workers on the same node are robbed first.
+        steal_order.resize(number_of_workers + 1);
+        for (unsigned worker = 0; worker <= number_of_workers; ++worker) {
+            std::vector<unsigned>& order = steal_order[worker];
+            if (worker == number_of_workers) {
+                for (unsigned victim = 0; victim < number_of_workers;
+                        ++victim) {
+                    order.push_back(victim);
+                }
+                continue;
+            }
+            const unsigned node = queues[worker]->node;
+            for (unsigned i = 1; i < number_of_workers; ++i) {
+                const unsigned victim = (worker + i) % number_of_workers;
+                if (queues[victim]->node == node) {
+                    order.push_back(victim);
+                }
+            }
+            for (unsigned i = 1; i < number_of_workers; ++i) {
+                const unsigned victim = (worker + i) % number_of_workers;
+                if (queues[victim]->node != node) {
+                    order.push_back(victim);
+                }
+            }
+        }
+
+        static const std::vector<unsigned> no_cpus;
+
+        for (unsigned i = 0; i < number_of_workers; ++i) {
+            threads.emplace_back(&VCF_thread_pool_impl::worker_loop, this, i,
+                    topology != nullptr ?
+                            topology->get_node_cpus_impl(queues[i]->node) :
+                            no_cpus);
+        }
+    }
+
+    // Must be called by the destructor of the final class while
+    // the virtual methods that the running tasks may call are
+    // still intact.
+    void stop_workers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            stopping = true;
+        }
+        idle_cv.notify_all();
+
+        for (auto& thread : threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+
+    void submit_impl(Task&& task)
+    {
+        const unsigned worker_index = get_current_worker_index();
+
+        // Tasks submitted by a worker go to the back of its own queue,
+        // where they are likely to find warm caches. Tasks from the
+        // outside are distributed round-robin.
+        push_task(worker_index < queues.size() ?
+                        worker_index :
+                        next_queue++ % (unsigned) queues.size(),
+                std::move(task));
+    }
+
+    void submit_to_node_impl(unsigned node, Task&& task)
+    {
+        const unsigned worker_index = get_current_worker_index();
+
+        if (worker_index < queues.size() &&
+                queues[worker_index]->node == node) {
+            push_task(worker_index, std::move(task));
+        } else {
+            const std::vector<unsigned>& workers =
+                    node_workers[node % node_workers.size()];
+            push_task(workers[next_queue++ % workers.size()], std::move(task));
+        }
+    }
+
+    unsigned get_current_node_impl() const
+    {
+        const unsigned worker_index = get_current_worker_index();
+
+        return worker_index < queues.size() ? queues[worker_index]->node : 0;
+    }
+
+    void push_task(unsigned worker_index, Task&& task)
+    {
+        Worker_queue& queue = *queues[worker_index];
+
+        // The task is counted before it becomes visible, so that
+        // the worker that takes it cannot decrement the count first.
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            ++queued_tasks;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        idle_cv.notify_one();
+    }
+
+    bool run_pending_task_impl()
+    {
+        Task task;
+
+        if (!pop_task(get_current_worker_index(), &task)) {
+            return false;
+        }
+
+        task();
+        return true;
+    }
+
+    struct Worker_queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        unsigned node;
+    };
+
+    std::vector<std::unique_ptr<Worker_queue>> queues;
+    std::vector<std::thread> threads;
+
+    // Worker indices grouped by NUMA node.
+    std::vector<std::vector<unsigned>> node_workers;
+    // For each worker and for the outside threads (the last
+    // element), the order in which other workers are robbed.
+    std::vector<std::vector<unsigned>> steal_order;
+
+    std::mutex idle_mutex;
+    std::condition_variable idle_cv;
+    std::atomic<size_t> queued_tasks{0};
+    bool stopping = false;
+
+    std::atomic<unsigned> next_queue{0};
+
+    struct Current_worker {
+        const VCF_thread_pool_impl* pool;
+        unsigned index;
+    };
+
+    static Current_worker& current_worker()
+    {
+        static thread_local Current_worker worker = {nullptr, 0};
+        return worker;
+    }
+
+    // Returns the index of the worker running the calling thread
+    // or the number of workers if the caller is not a worker of
+    // this pool.
+    unsigned get_current_worker_index() const
+    {
+        const Current_worker& worker = current_worker();
+        return worker.pool == this ? worker.index : (unsigned) queues.size();
+    }
+
+    // Takes the most recently queued task of the given worker. If
+    // that worker has nothing to do, steals the oldest task from
+    // one of its peers.
+    bool pop_task(unsigned worker_index, Task* task)
+    {
+        if (worker_index < queues.size()) {
+            Worker_queue& own_queue = *queues[worker_index];
+            std::lock_guard<std::mutex> lock(own_queue.mutex);
+            if (!own_queue.tasks.empty()) {
+                *task = std::move(own_queue.tasks.back());
+                own_queue.tasks.pop_back();
+                --queued_tasks;
+                return true;
+            }
+        }
+
+        for (unsigned victim_index : steal_order[worker_index]) {
+            Worker_queue& victim = *queues[victim_index];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                *task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                --queued_tasks;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void worker_loop(unsigned worker_index, const std::vector<unsigned>& cpus)
+    {
+        // Pin the thread before it touches any memory, so that
+        // the pages it allocates come from the local node.
+        if (!cpus.empty()) {
+            VCF_numa_topology_impl::bind_current_thread(cpus);
+        }
+
+        current_worker().pool = this;
+        current_worker().index = worker_index;
+
+        Task task;
+
+        for (;;) {
+            if (pop_task(worker_index, &task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(idle_mutex);
+            idle_cv.wait(lock, [this] { return stopping || queued_tasks > 0; });
+            if (stopping && queued_tasks == 0) {
+                return;
+            }
+        }
+    }
+};
+
+class VCF_task_group_impl
+{
+protected:
+    explicit VCF_task_group_impl(VCF_executor& e) : executor(e) {}
+
+    ~VCF_task_group_impl()
+    {
+        wait_impl();
+    }
+
+    void run_impl(VCF_executor::Task&& task)
+    {
+        ++unfinished_tasks;
+
+        executor.submit(std::bind(&VCF_task_group_impl::run_and_count_down,
+                this, std::move(task)));
+    }
+
+    void run_on_node_impl(unsigned node, VCF_executor::Task&& task)
+    {
+        ++unfinished_tasks;
+
+        executor.submit_to_node(node,
+                std::bind(&VCF_task_group_impl::run_and_count_down, this,
+                        std::move(task)));
+    }
+
+    void run_and_count_down(const VCF_executor::Task& task)
+    {
+        task();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--unfinished_tasks == 0) {
+            done_cv.notify_all();
+        }
+    }
+
+    void wait_impl()
+    {
+        while (unfinished_tasks > 0) {
+            // Help the executor instead of blocking one of its threads.
+            if (executor.run_pending_task()) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            done_cv.wait_for(lock, std::chrono::milliseconds(1),
+                    [this] { return unfinished_tasks == 0; });
+        }
+
+        // Make sure the last task has released the mutex
+        // before this object can be destroyed.
+        std::lock_guard<std::mutex> lock(mutex);
+    }
+
+    VCF_executor& executor;
+
+    std::atomic<size_t> unfinished_tasks{0};
+
+    std::mutex mutex;
+    std::condition_variable done_cv;
+};
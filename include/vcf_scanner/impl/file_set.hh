@@ -0,0 +1,132 @@
+// This header contains implementation details.
+#ifndef VCF_PARALLEL__HH
+#    error this file is not meant to be included directly
+#endif
+
+class VCF_file_set_impl
+{
+protected:
+    struct File {
+        std::string pathname;
+        std::unique_ptr<VCF_file_input> input;
+        VCF_header header;
+        VCF_byte_range data_range;
+    };
+
+    std::vector<std::unique_ptr<File>> files;
+
+    std::string error_message;
+
+    bool add_file_impl(const char* pathname)
+    {
+        std::unique_ptr<File> file(new File);
+
+        file->pathname = pathname;
+        file->input.reset(new VCF_file_input(pathname));
+        if (!file->input->is_open()) {
+            error_message = file->input->get_error();
+            return false;
+        }
+
+        VCF_shard_planner shard_planner(*file->input);
+        if (shard_planner.parse_header(&file->header) !=
+                VCF_parsing_event::ok) {
+            error_message = file->pathname + ": " + shard_planner.get_error();
+            return false;
+        }
+        file->data_range.begin = shard_planner.get_data_offset();
+        file->data_range.end = file->input->get_size();
+
+        if (!files.empty()) {
+            const File& first_file = *files.front();
+
+            if (file->header.get_file_format_version() !=
+                    first_file.header.get_file_format_version()) {
+                error_message = file->pathname +
+                        ": file format version differs from that of " +
+                        first_file.pathname;
+                return false;
+            }
+            if (file->header.get_sample_ids() !=
+                    first_file.header.get_sample_ids()) {
+                error_message = file->pathname +
+                        ": sample IDs differ from those in " +
+                        first_file.pathname;
+                return false;
+            }
+        }
+
+        files.push_back(std::move(file));
+        return true;
+    }
+
+    void scan_in_parallel_impl(VCF_executor& executor,
+            const VCF_range_scheduler::Processor& processor,
+            size_t buffer_size)
+    {
+        VCF_range_scheduler scheduler(executor, buffer_size);
+
+        for (const auto& file : files) {
+            scheduler.add_job(*file->input, file->header, file->data_range);
+        }
+
+        scheduler.run(processor);
+
+        for (size_t i = 0; i < files.size(); ++i) {
+            if (!scheduler.get_job_error(i).empty()) {
+                error_message = files[i]->pathname + ": " +
+                        scheduler.get_job_error(i);
+                return;
+            }
+        }
+    }
+
+    // The state of the sequential reading of all files.
+    size_t current_file_index = 0;
+    std::unique_ptr<VCF_range_feeder> current_feeder;
+
+    VCF_parsing_event read_and_feed_impl(VCF_scanner& scanner)
+    {
+        while (current_file_index < files.size()) {
+            const File& file = *files[current_file_index];
+
+            if (!current_feeder) {
+                current_feeder.reset(
+                        new VCF_range_feeder(*file.input, file.data_range));
+            }
+
+            if (!current_feeder->at_end_of_range()) {
+                const VCF_parsing_event pe =
+                        current_feeder->read_and_feed(scanner);
+                if (pe == VCF_parsing_event::error &&
+                        !current_feeder->get_error().empty()) {
+                    error_message =
+                            file.pathname + ": " + current_feeder->get_error();
+                }
+                return pe;
+            }
+
+            current_feeder.reset();
+            ++current_file_index;
+
+            if (file.data_range.begin < file.data_range.end) {
+                // Terminate the last line of the file if needed,
+                // so that it does not merge with the first line of
+                // the next file.
+                char last_char;
+                if (file.input->read_at(file.data_range.end - 1, &last_char,
+                            1) != 1) {
+                    error_message =
+                            file.pathname + ": " + file.input->get_error();
+                    return VCF_parsing_event::error;
+                }
+                if (last_char != '\n' && current_file_index < files.size()) {
+                    static const char newline = '\n';
+                    return scanner.feed(&newline, 1);
+                }
+            }
+        }
+
+        return scanner.feed(nullptr, 0);
+    }
+};
@@ -0,0 +1,190 @@
+// This header contains implementation details.
+#ifndef VCF_SCANNER__HH
+#    error this file is not meant to be included directly
+#endif
+
+#include <cfloat>
+#include <clocale>
+
+// Converts decimal numbers to 'float' without copying them into a
+// null-terminated buffer. Numbers whose significant digits form an
+// integer of at most 2^53 (which includes all numbers of up to 15
+// digits) and whose decimal exponent is small, which covers nearly all
+// values found in VCF files, are converted with a single correctly
+// rounded multiplication or division (Clinger's fast path). The
+// remaining numbers are passed to 'strtof()' with the dot replaced by
+// the decimal point of the current locale. Locales with a multibyte
+// decimal point are not supported.
+class VCF_float_parser
+{
+public:
+    // Parses a floating-point number that occupies the entire range.
+    // A single dot is converted to VCF_missing_float.
+    static bool parse(const char* ptr, const char* end, float* value)
+    {
+        if (end - ptr == 1 && *ptr == '.') {
+            *value = VCF_missing_float;
+            return true;
+        }
+
+        const char* number = ptr;
+        bool negative = false;
+        if (ptr < end && (*ptr == '-' || *ptr == '+')) {
+            negative = *ptr++ == '-';
+        }
+        // Hexadecimal numbers are left to 'strtof()'.
+        if (end - ptr > 1 && ptr[0] == '0' &&
+                (ptr[1] == 'x' || ptr[1] == 'X')) {
+            return parse_slowly(number, end, value);
+        }
+
+        uint64_t mantissa = 0;
+        unsigned significant_digits = 0;
+        unsigned digits = 0;
+        int exponent = 0;
+        unsigned digit;
+
+        for (; ptr < end && (digit = (unsigned) *ptr - '0') <= 9; ++ptr) {
+            mantissa = mantissa * 10 + digit;
+            significant_digits += mantissa != 0;
+            ++digits;
+        }
+        if (ptr < end && *ptr == '.') {
+            while (++ptr < end && (digit = (unsigned) *ptr - '0') <= 9) {
+                mantissa = mantissa * 10 + digit;
+                significant_digits += mantissa != 0;
+                ++digits;
+                --exponent;
+            }
+        }
+
+        // The mantissa may have overflowed, or the number is
+        // "inf" or "nan".
+        if (digits == 0 || significant_digits > max_significant_digits) {
+            return parse_slowly(number, end, value);
+        }
+
+        if (ptr < end && (*ptr == 'e' || *ptr == 'E')) {
+            bool negative_exponent = false;
+            if (++ptr < end && (*ptr == '-' || *ptr == '+')) {
+                negative_exponent = *ptr++ == '-';
+            }
+            if (ptr == end) {
+                return false;
+            }
+            int explicit_exponent = 0;
+            do {
+                if ((digit = (unsigned) *ptr - '0') > 9) {
+                    return false;
+                }
+                if (explicit_exponent < 10000) {
+                    explicit_exponent = explicit_exponent * 10 + (int) digit;
+                }
+            } while (++ptr < end);
+            exponent += negative_exponent ? -explicit_exponent :
+                                            explicit_exponent;
+        }
+
+        if (ptr != end) {
+            return false;
+        }
+
+        if (convert_exactly(mantissa, exponent, value)) {
+            if (negative) {
+                *value = -*value;
+            }
+            return true;
+        }
+
+        return parse_slowly(number, end, value);
+    }
+
+    // Converts 'mantissa * 10^exponent' to the nearest float when a
+    // single multiplication or division gives the correctly rounded
+    // result. Returns false otherwise; the decimal text must then be
+    // passed to 'parse()'.
+    static bool convert_exactly(uint64_t mantissa, int exponent, float* value)
+    {
+#if FLT_EVAL_METHOD == 0
+        if (mantissa == 0) {
+            *value = 0.0f;
+            return true;
+        }
+
+        // Both the mantissa and the power of ten are exact doubles, so
+        // the result is the correctly rounded double.  Rounding it to
+        // 'float' gives the correctly rounded float unless the double
+        // is halfway between two floats.  Within these bounds, the
+        // result is a normal float.
+        if (mantissa <= max_exact_mantissa && exponent >= -max_exact_power &&
+                exponent <= max_exact_power) {
+            double result = (double) mantissa;
+            if (exponent < 0) {
+                result /= powers_of_ten()[-exponent];
+            } else {
+                result *= powers_of_ten()[exponent];
+            }
+
+            uint64_t bits;
+            memcpy(&bits, &result, sizeof(bits));
+            // The 29 low bits of the double mantissa are dropped
+            // when it is rounded to the 24-bit float mantissa.
+            if ((bits & 0x1FFFFFFF) != 0x10000000) {
+                *value = (float) result;
+                return true;
+            }
+        }
+#else
+        (void) mantissa;
+        (void) exponent;
+        (void) value;
+#endif
+        return false;
+    }
+
+private:
+    // 10^19 < 2^64, so the mantissa cannot overflow.
+    static constexpr unsigned max_significant_digits = 19;
+
+    // The largest power of ten that is an exact double.
+    static constexpr int max_exact_power = 22;
+
+    // Integers up to 2^53 are exact doubles.
+    static constexpr uint64_t max_exact_mantissa = (uint64_t) 1 << 53;
+
+    static const double* powers_of_ten()
+    {
+        static const double powers[max_exact_power + 1] = {1e0, 1e1, 1e2,
+                1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+                1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        return powers;
+    }
+
+    static bool parse_slowly(const char* ptr, const char* end, float* value)
+    {
+        char number[64];
+        const size_t len = end - ptr;
+        if (len == 0 || len >= sizeof(number)) {
+            return false;
+        }
+        memcpy(number, ptr, len);
+        number[len] = '\0';
+
+        // VCF numbers always use a dot, whereas 'strtof()' expects
+        // the decimal point of the current locale.
+        const char decimal_point = *localeconv()->decimal_point;
+        if (decimal_point != '.') {
+            if (memchr(number, decimal_point, len) != nullptr) {
+                return false;
+            }
+            char* const dot = (char*) memchr(number, '.', len);
+            if (dot != nullptr) {
+                *dot = decimal_point;
+            }
+        }
+
+        char* number_end;
+        *value = strtof(number, &number_end);
+        return number_end == number + len;
+    }
+};
@@ -13,13 +13,212 @@ protected:
     void add_meta_info(
             std::string&& meta_info_key, const VCF_string_view& meta_info_line)
     {
+        if (meta_info_key == "INFO") {
+            const std::string* key =
+                    add_key_definition(&info_definitions, meta_info_line);
+            if (key != nullptr && info_definitions[*key].data_type ==
+                                          VCF_key_definition::flag_type) {
+                info_flag_keys.push_back(*key);
+            }
+        } else if (meta_info_key == "FORMAT") {
+            add_key_definition(&format_definitions, meta_info_line);
+        } else if (meta_info_key == "contig") {
+            add_contig(meta_info_line);
+        } else if (meta_info_key == "FILTER") {
+            add_filter(meta_info_line);
+        }
+
         meta_info[meta_info_key].push_back(meta_info_line);
     }
 
+    typedef std::vector<std::pair<std::string, std::string>> Structured_value;
+
+    // Splits a structured meta-information value like
+    // <ID=20,length=62435964,assembly=B36> into key-value pairs.
+    // Double quotes around values are removed.
+    static bool parse_structured_value(
+            const VCF_string_view& value, Structured_value* fields)
+    {
+        fields->clear();
+
+        const size_t len = value.length();
+
+        if (len < 2 || value.front() != '<' || value.back() != '>') {
+            return false;
+        }
+
+        size_t pos = 1;
+
+        while (pos < len - 1) {
+            const size_t equals_sign = value.find('=', pos);
+            if (equals_sign == std::string::npos) {
+                return false;
+            }
+            fields->emplace_back(
+                    value.substr(pos, equals_sign - pos), std::string());
+            std::string& field_value = fields->back().second;
+
+            pos = equals_sign + 1;
+            if (value[pos] == '"') {
+                for (;;) {
+                    if (++pos >= len - 1) {
+                        return false;
+                    }
+                    if (value[pos] == '"') {
+                        break;
+                    }
+                    if (value[pos] == '\\' && pos + 1 < len - 1) {
+                        ++pos;
+                    }
+                    field_value += value[pos];
+                }
+                ++pos;
+            } else {
+                while (pos < len - 1 && value[pos] != ',') {
+                    field_value += value[pos++];
+                }
+            }
+
+            if (pos < len - 1) {
+                if (value[pos] != ',') {
+                    return false;
+                }
+                ++pos;
+            }
+        }
+
+        return true;
+    }
+
+    static const std::string* find_structured_field(
+            const Structured_value& fields, const char* key)
+    {
+        for (const auto& field : fields) {
+            if (field.first == key) {
+                return &field.second;
+            }
+        }
+        return nullptr;
+    }
+
+    // Meta-information lines that cannot be interpreted are
+    // kept in 'meta_info' but otherwise ignored.
+    // Returns the key of the added definition or nullptr if
+    // the definition is malformed.
+    static const std::string* add_key_definition(
+            std::map<std::string, VCF_key_definition>* definitions,
+            const VCF_string_view& meta_info_line)
+    {
+        Structured_value fields;
+        if (!parse_structured_value(meta_info_line, &fields)) {
+            return nullptr;
+        }
+
+        const std::string* id = find_structured_field(fields, "ID");
+        const std::string* number = find_structured_field(fields, "Number");
+        const std::string* type = find_structured_field(fields, "Type");
+        if (id == nullptr || number == nullptr || type == nullptr) {
+            return nullptr;
+        }
+
+        VCF_key_definition definition;
+
+        if (*type == "Integer") {
+            definition.data_type = VCF_key_definition::integer_type;
+        } else if (*type == "Float") {
+            definition.data_type = VCF_key_definition::float_type;
+        } else if (*type == "Flag") {
+            definition.data_type = VCF_key_definition::flag_type;
+        } else if (*type == "Character") {
+            definition.data_type = VCF_key_definition::character_type;
+        } else if (*type == "String") {
+            definition.data_type = VCF_key_definition::string_type;
+        } else {
+            return nullptr;
+        }
+
+        definition.number = 0;
+        if (*number == "A") {
+            definition.number_of_values = VCF_key_definition::one_per_alt;
+        } else if (*number == "R") {
+            definition.number_of_values = VCF_key_definition::one_per_allele;
+        } else if (*number == "G") {
+            definition.number_of_values = VCF_key_definition::one_per_genotype;
+        } else if (*number == ".") {
+            definition.number_of_values = VCF_key_definition::unbound;
+        } else {
+            char* end;
+            const unsigned long n = strtoul(number->c_str(), &end, 10);
+            if (number->empty() || *end != '\0' || n > UINT_MAX) {
+                return nullptr;
+            }
+            definition.number_of_values = VCF_key_definition::exact_number;
+            definition.number = (unsigned) n;
+        }
+
+        const std::string* description =
+                find_structured_field(fields, "Description");
+        if (description != nullptr) {
+            definition.description = *description;
+        }
+
+        const auto entry = definitions->emplace(*id, definition);
+        if (!entry.second) {
+            entry.first->second = std::move(definition);
+        }
+        return &entry.first->first;
+    }
+
+    void add_contig(const VCF_string_view& meta_info_line)
+    {
+        Structured_value fields;
+        if (!parse_structured_value(meta_info_line, &fields)) {
+            return;
+        }
+
+        const std::string* id = find_structured_field(fields, "ID");
+        if (id == nullptr) {
+            return;
+        }
+
+        unsigned long long length = 0;
+        const std::string* length_str = find_structured_field(fields, "length");
+        if (length_str != nullptr) {
+            length = strtoull(length_str->c_str(), nullptr, 10);
+        }
+
+        contigs.push_back(VCF_contig{*id, length});
+    }
+
+    void add_filter(const VCF_string_view& meta_info_line)
+    {
+        Structured_value fields;
+        if (!parse_structured_value(meta_info_line, &fields)) {
+            return;
+        }
+
+        const std::string* id = find_structured_field(fields, "ID");
+        if (id == nullptr) {
+            return;
+        }
+
+        const std::string* description =
+                find_structured_field(fields, "Description");
+
+        filters.push_back(VCF_filter{
+                *id, description != nullptr ? *description : std::string()});
+    }
+
     std::string file_format_version;
     std::map<std::string, std::vector<std::string>> meta_info;
     bool genotype_info_present = false;
     std::vector<std::string> sample_ids;
+    std::vector<VCF_contig> contigs;
+    std::vector<VCF_filter> filters;
+    std::map<std::string, VCF_key_definition> info_definitions;
+    // Keys of the Flag INFO definitions in the order of declaration.
+    std::vector<std::string> info_flag_keys;
+    std::map<std::string, VCF_key_definition> format_definitions;
 
     friend class VCF_scanner_impl;
 };
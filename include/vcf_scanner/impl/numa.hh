@@ -0,0 +1,136 @@
+// This header contains implementation details.
+#ifndef VCF_PARALLEL__HH
+#    error this file is not meant to be included directly
+#endif
+
+#ifdef __linux__
+#    include <sched.h>
+#endif
+
+class VCF_numa_topology_impl
+{
+protected:
+    void detect_impl()
+    {
+        node_cpus.clear();
+
+#ifdef __linux__
+        // Node IDs are not necessarily contiguous.
+        std::string node_list;
+        std::vector<unsigned> nodes;
+        if (read_sysfs_file("/sys/devices/system/node/online", &node_list)) {
+            parse_cpu_list(node_list, &nodes);
+        }
+
+        for (unsigned node : nodes) {
+            std::string cpu_list;
+            if (!read_sysfs_file("/sys/devices/system/node/node" +
+                                std::to_string(node) + "/cpulist",
+                        &cpu_list)) {
+                continue;
+            }
+
+            // Memory-only nodes cannot host worker threads.
+            std::vector<unsigned> cpus;
+            if (parse_cpu_list(cpu_list, &cpus) && !cpus.empty()) {
+                node_cpus.push_back(std::move(cpus));
+            }
+        }
+#endif
+
+        if (node_cpus.empty()) {
+            // Unknown topology: a single node without CPU binding.
+            node_cpus.resize(1);
+        }
+    }
+
+#ifdef __linux__
+    static bool read_sysfs_file(const std::string& path, std::string* contents)
+    {
+        FILE* file = fopen(path.c_str(), "r");
+        if (file == nullptr) {
+            return false;
+        }
+
+        char buffer[256];
+        size_t bytes_read;
+        while ((bytes_read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            contents->append(buffer, bytes_read);
+        }
+        fclose(file);
+        return true;
+    }
+#endif
+
+    // Parses a CPU list in the format used by sysfs, e.g. "0-3,8,10-11".
+    // Node lists use the same format.
+    static bool parse_cpu_list(
+            const std::string& cpu_list, std::vector<unsigned>* cpus)
+    {
+        const char* ptr = cpu_list.c_str();
+
+        for (;;) {
+            while (*ptr == ' ' || *ptr == '\n') {
+                ++ptr;
+            }
+            if (*ptr == '\0') {
+                return true;
+            }
+
+            char* end;
+            const unsigned long first_cpu = strtoul(ptr, &end, 10);
+            if (end == ptr) {
+                return false;
+            }
+            unsigned long last_cpu = first_cpu;
+            if (*end == '-') {
+                ptr = end + 1;
+                last_cpu = strtoul(ptr, &end, 10);
+                if (end == ptr || last_cpu < first_cpu) {
+                    return false;
+                }
+            }
+            for (unsigned long cpu = first_cpu; cpu <= last_cpu; ++cpu) {
+                cpus->push_back((unsigned) cpu);
+            }
+
+            ptr = end;
+            if (*ptr == ',') {
+                ++ptr;
+            }
+        }
+    }
+
+    unsigned get_number_of_nodes_impl() const
+    {
+        return (unsigned) node_cpus.size();
+    }
+
+    const std::vector<unsigned>& get_node_cpus_impl(unsigned node) const
+    {
+        return node_cpus[node];
+    }
+
+    // Restricts the calling thread to the specified CPUs. Has no effect
+    // on platforms that do not support thread affinity.
+    static void bind_current_thread(const std::vector<unsigned>& cpus)
+    {
+#ifdef __linux__
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        for (unsigned cpu : cpus) {
+            if (cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &cpu_set);
+            }
+        }
+        sched_setaffinity(0, sizeof(cpu_set), &cpu_set);
+#else
+        (void) cpus;
+#endif
+    }
+
+    // CPUs of each node that has at least one CPU.
+    std::vector<std::vector<unsigned>> node_cpus;
+
+    friend class VCF_thread_pool_impl;
+};
@@ -0,0 +1,44 @@
+// This header contains implementation details.
+#ifndef VCF_PARALLEL__HH
+#    error this file is not meant to be included directly
+#endif
+
+class VCF_range_feeder_impl
+{
+protected:
+    VCF_range_feeder_impl(const VCF_input& i, const VCF_byte_range& r,
+            size_t buffer_size) :
+        input(i), range(r), current_offset(r.begin), buffer(buffer_size)
+    {}
+
+    VCF_parsing_event read_and_feed_impl(VCF_scanner& scanner)
+    {
+        size_t bytes_to_read = buffer.size();
+        if (bytes_to_read > range.end - current_offset) {
+            bytes_to_read = (size_t) (range.end - current_offset);
+        }
+
+        if (bytes_to_read == 0) {
+            // A buffer of zero size signals the end of the range.
+            return scanner.feed(buffer.data(), 0);
+        }
+
+        const ssize_t bytes_read =
+                input.read_at(current_offset, buffer.data(), bytes_to_read);
+        if (bytes_read <= 0) {
+            error_message = bytes_read < 0 ? input.get_error() :
+                                             "Unexpected end of input";
+            return VCF_parsing_event::error;
+        }
+
+        current_offset += (uint64_t) bytes_read;
+
+        return scanner.feed(buffer.data(), bytes_read);
+    }
+
+    const VCF_input& input;
+    const VCF_byte_range range;
+    uint64_t current_offset;
+    std::vector<char> buffer;
+    std::string error_message;
+};
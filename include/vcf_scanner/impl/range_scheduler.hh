@@ -0,0 +1,77 @@
+// This header contains implementation details.
+#ifndef VCF_PARALLEL__HH
+#    error this file is not meant to be included directly
+#endif
+
+class VCF_range_scheduler_impl
+{
+protected:
+    VCF_range_scheduler_impl(VCF_executor& e, size_t bs) :
+        executor(e), buffer_size(bs)
+    {}
+
+    struct Job {
+        const VCF_input* input;
+        const VCF_header* header;
+        VCF_byte_range range;
+        std::string error_message;
+    };
+
+    std::vector<Job> jobs;
+
+    template <typename Processor>
+    void run_impl(const Processor& processor)
+    {
+        // Longest processing time first: large jobs start early,
+        // and small jobs fill the gaps at the end.
+        std::vector<size_t> order(jobs.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(
+                order.begin(), order.end(), [this](size_t l, size_t r) {
+                    return jobs[l].range.end - jobs[l].range.begin >
+                            jobs[r].range.end - jobs[r].range.begin;
+                });
+
+        const unsigned number_of_nodes = executor.get_number_of_nodes();
+
+        VCF_task_group task_group(executor);
+
+        for (size_t rank = 0; rank < order.size(); ++rank) {
+            const size_t job_index = order[rank];
+
+            task_group.run_on_node((unsigned) (rank % number_of_nodes),
+                    [this, job_index, &processor] {
+                        run_job(job_index, processor);
+                    });
+        }
+
+        task_group.wait();
+    }
+
+    template <typename Processor>
+    void run_job(size_t job_index, const Processor& processor)
+    {
+        // The scanner and the input buffer are created by
+        // the worker, which places them in its local memory.
+        Job& job = jobs[job_index];
+
+        VCF_scanner scanner;
+        VCF_range_feeder feeder(*job.input, job.range, buffer_size);
+
+        VCF_parsing_event pe = scanner.start_at_data_line(*job.header);
+        while (pe == VCF_parsing_event::need_more_data) {
+            pe = feeder.read_and_feed(scanner);
+        }
+        if (pe == VCF_parsing_event::error) {
+            job.error_message = feeder.get_error();
+            return;
+        }
+
+        processor(job_index, scanner, feeder);
+    }
+
+    VCF_executor& executor;
+    const size_t buffer_size;
+};
@@ -0,0 +1,262 @@
+// This header contains implementation details.
+#ifndef VCF_SCANNER__HH
+#    error this file is not meant to be included directly
+#endif
+
+#include "string_pool.hh"
+#include "float_parser.hh"
+
+class VCF_scanner_impl;
+
+class VCF_record_impl
+{
+protected:
+    enum Field {
+        chrom_field,
+        pos_field,
+        id_field,
+        ref_field,
+        alt_field,
+        quality_field,
+        filter_field,
+        info_field,
+        number_of_fields
+    };
+
+    // Copies the tab-separated mandatory fields of a data line and
+    // locates their boundaries. Returns the number of fields found.
+    unsigned assign(const char* fields, size_t fields_len)
+    {
+        text.assign(fields, fields_len);
+        decoded_fields = 0;
+
+        const char* const begin = text.data();
+        const char* const end = begin + fields_len;
+
+        unsigned field = 0;
+        field_starts[0] = 0;
+
+        while (field < number_of_fields - 1) {
+            const char* const tab = (const char*) memchr(
+                    begin + field_starts[field], '\t',
+                    end - begin - field_starts[field]);
+            if (tab == nullptr) {
+                break;
+            }
+            field_starts[++field] = tab - begin + 1;
+        }
+
+        // Pretend that the last field is followed by a tab.
+        field_starts[field + 1] = fields_len + 1;
+
+        return field + 1;
+    }
+
+    const char* get_field(Field field, size_t* len) const
+    {
+        *len = field_starts[field + 1] - 1 - field_starts[field];
+        return text.data() + field_starts[field];
+    }
+
+    // Returns false if the text is not a valid unsigned integer.
+    static bool parse_pos(const char* ptr, size_t len, unsigned* pos)
+    {
+        if (len == 0) {
+            return false;
+        }
+
+        *pos = 0;
+        do {
+            const unsigned digit = (unsigned) *ptr++ - '0';
+            if (digit > 9 || *pos > (UINT_MAX - digit) / 10) {
+                return false;
+            }
+            *pos = *pos * 10 + digit;
+        } while (--len > 0);
+
+        return true;
+    }
+
+    // Returns true if the field is accessed for the first time.
+    bool needs_decoding(Field field)
+    {
+        const unsigned field_bit = 1U << field;
+
+        if ((decoded_fields & field_bit) != 0) {
+            return false;
+        }
+        decoded_fields |= field_bit;
+        return true;
+    }
+
+    static bool is_dot(const char* ptr, const char* end)
+    {
+        return ptr == end || (end - ptr == 1 && *ptr == '.');
+    }
+
+    // Splits a list field the same way 'VCF_scanner' does:
+    // missing values ('.') are not included.
+    void split_field(
+            Field field, char separator, std::vector<std::string>* values)
+    {
+        size_t number_of_values = 0;
+
+        size_t len;
+        const char* ptr = get_field(field, &len);
+        const char* const end = ptr + len;
+
+        for (;;) {
+            const char* value_end =
+                    (const char*) memchr(ptr, separator, end - ptr);
+            if (value_end == nullptr) {
+                value_end = end;
+            }
+            if (!is_dot(ptr, value_end)) {
+                string_pool.set(
+                        values, number_of_values++, ptr, value_end - ptr);
+            }
+            if (value_end == end) {
+                string_pool.truncate(values, number_of_values);
+                return;
+            }
+            ptr = value_end + 1;
+        }
+    }
+
+    // Returns the number of ALT alleles without splitting the field.
+    unsigned count_alts() const
+    {
+        size_t len;
+        const char* ptr = get_field(alt_field, &len);
+        const char* const end = ptr + len;
+
+        unsigned number_of_alts = 0;
+
+        for (;;) {
+            const char* value_end = (const char*) memchr(ptr, ',', end - ptr);
+            if (value_end == nullptr) {
+                value_end = end;
+            }
+            if (!is_dot(ptr, value_end)) {
+                ++number_of_alts;
+            }
+            if (value_end == end) {
+                return number_of_alts;
+            }
+            ptr = value_end + 1;
+        }
+    }
+
+    // The mandatory fields of the data line separated by tabs.
+    std::string text;
+    // Offsets of the fields in 'text'. The element that follows the
+    // last field is one past the end of 'text'.
+    size_t field_starts[number_of_fields + 1];
+    // Bitmap of the fields whose values have been extracted.
+    unsigned decoded_fields = 0;
+
+    std::string chrom;
+    std::vector<std::string> ids;
+    std::string ref;
+    std::vector<std::string> alts;
+    std::string quality;
+    std::vector<std::string> filters;
+    std::vector<std::string> info;
+
+    VCF_string_pool string_pool;
+
+    friend class VCF_scanner_impl;
+};
+
+class VCF_record_batch_impl
+{
+protected:
+    VCF_record_batch_impl()
+    {
+        clear_impl();
+    }
+
+    void clear_impl()
+    {
+        chrom_ids.clear();
+        positions.clear();
+        qualities.clear();
+        filter_bits.clear();
+        text.clear();
+        text_offsets.assign(1, 0);
+    }
+
+    size_t get_number_of_records_impl() const
+    {
+        return positions.size();
+    }
+
+    // The variable-length fields, which are stored in the text
+    // arena one after another in the order of this enumeration.
+    enum Text_field { id_text, ref_text, alt_text, info_text, text_fields };
+
+    void add_text(const char* ptr, size_t len)
+    {
+        text.append(ptr, len);
+        text_offsets.push_back(text.length());
+    }
+
+    const char* get_text(size_t record, Text_field field, size_t* len) const
+    {
+        const size_t* const offsets =
+                text_offsets.data() + record * text_fields + field;
+        *len = offsets[1] - offsets[0];
+        return text.data() + offsets[0];
+    }
+
+    // Appends a record with an empty filter bitset. The text
+    // fields must be added separately.
+    void add_record(unsigned chrom_id, unsigned pos)
+    {
+        chrom_ids.push_back(chrom_id);
+        positions.push_back(pos);
+        filter_bits.resize(filter_bits.size() + filter_words, 0);
+    }
+
+    void add_filter(unsigned filter_id)
+    {
+        if (filter_id >= filter_words * 64) {
+            widen_filter_bits(filter_id / 64 + 1);
+        }
+        filter_bits[filter_bits.size() - filter_words + filter_id / 64] |=
+                uint64_t(1) << (filter_id % 64);
+    }
+
+    // Resizes every row of the bitmap to 'new_words' words.
+    void widen_filter_bits(size_t new_words)
+    {
+        const size_t old_words = filter_words;
+        filter_words = new_words;
+
+        std::vector<uint64_t> old_bits;
+        old_bits.swap(filter_bits);
+        filter_bits.resize(get_number_of_records_impl() * filter_words, 0);
+
+        for (size_t i = 0; i < get_number_of_records_impl(); ++i) {
+            std::copy(old_bits.begin() + i * old_words,
+                    old_bits.begin() + (i + 1) * old_words,
+                    filter_bits.begin() + i * filter_words);
+        }
+    }
+
+    std::vector<unsigned> chrom_ids;
+    std::vector<unsigned> positions;
+    std::vector<float> qualities;
+    // For each record, 'filter_words' words with one bit per
+    // filter ID.
+    std::vector<uint64_t> filter_bits;
+    size_t filter_words = 1;
+
+    // ID, REF, ALT, and INFO of all records. For each record,
+    // 'text_offsets' contains the start offsets of these
+    // fields, followed by the start offset of the next record.
+    std::string text;
+    std::vector<size_t> text_offsets;
+
+    friend class VCF_scanner_impl;
+};
@@ -4,6 +4,7 @@
 #endif
 
 #include "tokenizer.hh"
+#include "dictionary.hh"
 
 class VCF_scanner_impl
 {
@@ -13,6 +14,9 @@ protected:
         tokenizer.set_new_buffer(buffer, buffer_size);
 
         if (state == parsing_genotypes) {
+            if (gt_row_output != no_gt_row) {
+                return continue_parsing_gt_row();
+            }
             return continue_parsing_genotype();
         }
 
@@ -25,11 +29,10 @@ protected:
                 return continue_parsing_header();
             }
             if (state == parsing_chrom) {
-                const VCF_parsing_event pe = parse_string(parsing_pos);
+                const VCF_parsing_event pe = parse_chrom();
                 if (pe != VCF_parsing_event::ok) {
                     return pe;
                 }
-                *output.loc.chrom = tokenizer.get_token();
             }
             return continue_parsing_pos();
         }
@@ -71,6 +74,12 @@ protected:
             return continue_parsing_info();
         case parsing_genotype_format:
             return continue_parsing_genotype_format();
+        case indexing_genotypes:
+            return continue_indexing_genotypes();
+        case parsing_record:
+            return continue_parsing_record();
+        case parsing_batch:
+            return continue_parsing_batch();
         case skipping_to_next_line:
             if (!tokenizer.skip_token(tokenizer.find_newline())) {
                 return VCF_parsing_event::need_more_data;
@@ -92,13 +101,28 @@ protected:
     {
         assert(state == not_parsing);
 
-        output.header = header;
+        vcf_header = output.header = header;
 
         state = parsing_fileformat;
 
         return VCF_parsing_event::need_more_data;
     }
 
+    VCF_parsing_event start_at_data_line_impl(const VCF_header& header)
+    {
+        assert(state == not_parsing);
+
+        vcf_header = &header;
+        number_of_sample_ids = (unsigned) header.sample_ids.size();
+        load_dictionaries();
+
+        // Pretend that the header line has just been parsed and
+        // the parser is waiting for the first data line.
+        state = peeking_beyond_newline;
+
+        return VCF_parsing_event::need_more_data;
+    }
+
     VCF_parsing_event parse_loc_impl(std::string* chrom, unsigned* pos)
     {
         // LCOV_EXCL_START
@@ -114,18 +138,90 @@ protected:
         // LCOV_EXCL_STOP
 
         output.loc.chrom = chrom;
+        output.loc.contig_id = nullptr;
+        *(output.loc.pos = pos) = 0;
+        number_len = 0;
+
+        const VCF_parsing_event pe = parse_chrom();
+        if (pe != VCF_parsing_event::ok) {
+            return pe;
+        }
+
+        return continue_parsing_pos();
+    }
+
+    VCF_parsing_event parse_loc_impl(unsigned* contig_id, unsigned* pos)
+    {
+        // LCOV_EXCL_START
+        if (state != parsing_chrom) {
+            if (state < parsing_chrom) {
+                assert(false && "VCF header must be parsed first");
+                return invalid_call_order_error();
+            }
+
+            assert(false && "Must call clear_line() before parse_loc()");
+            return invalid_call_order_error();
+        }
+        // LCOV_EXCL_STOP
+
+        output.loc.chrom = nullptr;
+        output.loc.contig_id = contig_id;
         *(output.loc.pos = pos) = 0;
         number_len = 0;
 
-        const VCF_parsing_event pe = parse_string(parsing_pos);
+        const VCF_parsing_event pe = parse_chrom();
         if (pe != VCF_parsing_event::ok) {
             return pe;
         }
-        *output.loc.chrom = tokenizer.get_token();
 
         return continue_parsing_pos();
     }
 
+    VCF_parsing_event parse_record_impl(VCF_record_impl* record)
+    {
+        // LCOV_EXCL_START
+        if (state != parsing_chrom) {
+            if (state < parsing_chrom) {
+                assert(false && "VCF header must be parsed first");
+                return invalid_call_order_error();
+            }
+
+            assert(false && "Must call clear_line() before parse_record()");
+            return invalid_call_order_error();
+        }
+        // LCOV_EXCL_STOP
+
+        output.record = record;
+        record_tabs_to_find = number_of_mandatory_columns;
+        state = parsing_record;
+
+        return continue_parsing_record();
+    }
+
+    VCF_parsing_event parse_batch_impl(
+            VCF_record_batch_impl* batch, size_t max_records)
+    {
+        // LCOV_EXCL_START
+        if (state != parsing_chrom) {
+            if (state < parsing_chrom) {
+                assert(false && "VCF header must be parsed first");
+                return invalid_call_order_error();
+            }
+
+            assert(false && "Must call clear_line() before parse_batch()");
+            return invalid_call_order_error();
+        }
+        // LCOV_EXCL_STOP
+
+        batch->clear_impl();
+        output.batch = batch;
+        batch_size = max_records;
+        batch_line_state = batch_line_start;
+        state = parsing_batch;
+
+        return continue_parsing_batch();
+    }
+
     VCF_parsing_event parse_ids_impl(std::vector<std::string>* ids)
     {
         output.ids = ids;
@@ -165,7 +261,21 @@ protected:
 
     VCF_parsing_event parse_quality_impl(std::string* quality_str)
     {
-        output.quality = quality_str;
+        output.quality.text = quality_str;
+        output.quality.value = nullptr;
+
+        const VCF_parsing_event pe = skip_to_state(parsing_quality);
+        if (pe != VCF_parsing_event::ok) {
+            return pe;
+        }
+
+        return continue_parsing_quality();
+    }
+
+    VCF_parsing_event parse_quality_impl(float* quality)
+    {
+        output.quality.text = nullptr;
+        output.quality.value = quality;
 
         const VCF_parsing_event pe = skip_to_state(parsing_quality);
         if (pe != VCF_parsing_event::ok) {
@@ -178,6 +288,7 @@ protected:
     VCF_parsing_event parse_filters_impl(std::vector<std::string>* filters)
     {
         output.filters = filters;
+        filters_as_ids = false;
 
         next_list_index = 0;
 
@@ -189,9 +300,28 @@ protected:
         return continue_parsing_filters();
     }
 
+    VCF_parsing_event parse_filters_impl(VCF_id_set* filter_ids)
+    {
+        output.filter_ids = filter_ids;
+        filters_as_ids = true;
+        filter_ids->clear();
+
+        VCF_parsing_event pe = skip_to_state(parsing_filter);
+        if (pe != VCF_parsing_event::ok) {
+            return pe;
+        }
+
+        return continue_parsing_filters();
+    }
+
     VCF_parsing_event parse_info_impl()
     {
-        info.clear();
+        string_pool.truncate(&info, 0);
+        reset_info_captures();
+        if (info_flags != nullptr) {
+            info_flags->clear();
+        }
+        keep_info_fields = true;
 
         const VCF_parsing_event pe = skip_to_state(parsing_info_field);
         if (pe != VCF_parsing_event::ok) {
@@ -201,10 +331,26 @@ protected:
         return continue_parsing_info();
     }
 
-    VCF_parsing_event parse_genotype_format_impl()
+    VCF_parsing_event parse_captured_info_impl()
     {
-        genotype_key_positions.clear();
+        string_pool.truncate(&info, 0);
+        reset_info_captures();
+        if (info_flags != nullptr) {
+            info_flags->clear();
+        }
+        keep_info_fields = false;
+        info_key_state = parsing_info_key;
+
+        const VCF_parsing_event pe = skip_to_state(parsing_info_field);
+        if (pe != VCF_parsing_event::ok) {
+            return pe;
+        }
+
+        return continue_parsing_info();
+    }
 
+    VCF_parsing_event parse_genotype_format_impl()
+    {
         const VCF_parsing_event pe = skip_to_state(parsing_genotype_format);
         if (pe != VCF_parsing_event::ok) {
             return pe;
@@ -215,17 +361,27 @@ protected:
 
     bool capture_gt_impl()
     {
-        unsigned gt_index = genotype_key_positions.gt;
+        if (genotype_values.empty()) {
+            return false;
+        }
+        unsigned gt_index = format_plan->gt;
         if (gt_index == 0) {
             return false;
         }
         --gt_index;
-        auto* gt_value = alloc_genotype_value(gt_index);
+        Genotype_value* gt_value = &genotype_values[gt_index];
         gt_value->data_type = vcf_gt;
+        gt_value->vector = true;
         gt_value->int_vector = &gt;
         return true;
     }
 
+    void clear_genotype_captures_impl()
+    {
+        std::fill(genotype_values.begin(), genotype_values.end(),
+                Genotype_value());
+    }
+
     VCF_parsing_event parse_genotype_impl()
     {
         // LCOV_EXCL_START
@@ -243,11 +399,368 @@ protected:
                     "the number of samples");
         }
 
+        if (!selected_samples.empty()) {
+            // LCOV_EXCL_START
+            if (current_output_sample >= selected_samples.size()) {
+                assert(false && "All selected samples have been parsed");
+                return invalid_call_order_error();
+            }
+            // LCOV_EXCL_STOP
+            genotype_columns_to_skip =
+                    selected_samples[current_output_sample] -
+                    current_genotype_field_index;
+        }
+        ++current_output_sample;
+
         current_genotype_value_index = 0;
+        reset_genotype_captures();
 
         return continue_parsing_genotype();
     }
 
+    VCF_parsing_event parse_gt_row_impl(
+            int8_t* alleles, uint8_t* phasing, unsigned ploidy)
+    {
+        // LCOV_EXCL_START
+        if (ploidy == 0 || ploidy > max_gt_row_ploidy) {
+            assert(false && "Unsupported genotype matrix ploidy");
+            return parsing_error("Unsupported genotype matrix ploidy");
+        }
+        // LCOV_EXCL_STOP
+
+        const unsigned first_sample = current_output_sample;
+        const unsigned number_of_samples = get_number_of_output_samples();
+
+        memset(alleles + (size_t) first_sample * ploidy,
+                (unsigned char) VCF_gt_missing,
+                (size_t) (number_of_samples - first_sample) * ploidy);
+        for (unsigned i = first_sample; i < number_of_samples; ++i) {
+            phasing[i / 8] &= (uint8_t) ~(1U << (i % 8));
+        }
+
+        gt_row_alleles = alleles;
+        gt_row_phasing = phasing;
+        gt_row_ploidy = ploidy;
+        gt_row_output = gt_matrix_row;
+
+        return start_parsing_gt_row();
+    }
+
+    VCF_parsing_event parse_gt_row_impl(VCF_genotype_matrix* matrix)
+    {
+        if (matrix->get_number_of_samples() < get_number_of_output_samples()) {
+            return parsing_error(
+                    "The genotype matrix has fewer samples than the output");
+        }
+
+        const size_t variant = matrix->add_variant();
+
+        return parse_gt_row_impl(matrix->get_alleles(variant),
+                matrix->get_phasing(variant), matrix->get_ploidy());
+    }
+
+    VCF_parsing_event parse_packed_gt_row_impl(
+            uint8_t* packed, VCF_multiallelic_policy policy)
+    {
+        const unsigned number_of_samples = get_number_of_output_samples();
+
+        for (unsigned i = current_output_sample; i < number_of_samples;
+                ++i) {
+            set_packed_gt(packed, i, VCF_packed_gt_missing);
+        }
+        // Unused bits of the last byte must be zero.
+        for (unsigned i = number_of_samples; i % 4 != 0; ++i) {
+            set_packed_gt(packed, i, 0);
+        }
+
+        gt_row_packed = packed;
+        multiallelic_policy = policy;
+        gt_row_output = gt_packed_row;
+
+        return start_parsing_gt_row();
+    }
+
+    VCF_parsing_event count_alleles_impl(VCF_allele_counts* counts)
+    {
+        counts->allele_counts.assign(alleles_parsed ? number_of_alts + 1 : 1,
+                0);
+        counts->number_of_called_alleles = 0;
+        counts->hom_ref = counts->het = counts->hom_alt = 0;
+        // Every sample is missing until its GT value is found.
+        counts->missing =
+                get_number_of_output_samples() - current_output_sample;
+
+        gt_row_counts = counts;
+        gt_row_output = gt_allele_counts;
+
+        return start_parsing_gt_row();
+    }
+
+    VCF_parsing_event parse_sparse_gt_row_impl(
+            VCF_sparse_gt_row* row, unsigned ploidy)
+    {
+        // LCOV_EXCL_START
+        if (ploidy == 0 || ploidy > max_gt_row_ploidy) {
+            assert(false && "Unsupported sparse genotype row ploidy");
+            return parsing_error("Unsupported sparse genotype row ploidy");
+        }
+        // LCOV_EXCL_STOP
+
+        row->ploidy = ploidy;
+        row->samples.clear();
+        row->alleles.clear();
+        row->phased.clear();
+
+        gt_row_sparse = row;
+        next_sparse_sample = current_output_sample;
+        gt_row_output = gt_sparse_row;
+
+        return start_parsing_gt_row();
+    }
+
+    VCF_parsing_event evaluate_gt_predicate_impl(
+            const VCF_gt_predicate& predicate, bool* result)
+    {
+        *result = predicate.min_samples == 0;
+        if (*result) {
+            return VCF_parsing_event::ok;
+        }
+
+        gt_predicate = predicate;
+        gt_predicate_result = result;
+        gt_predicate_count = 0;
+        gt_row_output = gt_predicate_row;
+
+        return start_parsing_gt_row();
+    }
+
+    template <typename Dosage>
+    VCF_parsing_event parse_dosage_row_impl(const char* key, Dosage* dosages,
+            unsigned values_per_sample, Dosage missing_dosage)
+    {
+        if (!is_dosage_key(key)) {
+            return parsing_error(std::string("FORMAT key '") + key +
+                    "' is not of type Float");
+        }
+
+        const unsigned first_sample = current_output_sample;
+        const unsigned number_of_samples = get_number_of_output_samples();
+
+        std::fill(dosages + (size_t) first_sample * values_per_sample,
+                dosages + (size_t) number_of_samples * values_per_sample,
+                missing_dosage);
+
+        set_dosage_row(dosages, values_per_sample);
+        dosage_row_key = key;
+
+        return start_parsing_gt_row();
+    }
+
+    // Like the 'capture_float...()' methods, accepts the keys declared
+    // with Type=Float or Type=Integer and the keys without a '##FORMAT'
+    // definition, but not GT.
+    bool is_dosage_key(const char* key) const
+    {
+        if (strcmp(key, "GT") == 0) {
+            return false;
+        }
+        if (vcf_header != nullptr) {
+            auto definition_iter = vcf_header->format_definitions.find(key);
+            if (definition_iter != vcf_header->format_definitions.end()) {
+                return is_compatible_definition(
+                        definition_iter->second, vcf_float, true);
+            }
+        }
+        return true;
+    }
+
+    void set_dosage_row(float* dosages, unsigned values_per_sample)
+    {
+        dosage_row_floats = dosages;
+        dosage_row_width = values_per_sample;
+        gt_row_output = dosage_float_row;
+    }
+
+    void set_dosage_row(uint16_t* dosages, unsigned values_per_sample)
+    {
+        dosage_row_fixed = dosages;
+        dosage_row_width = values_per_sample;
+        gt_row_output = dosage_fixed_row;
+    }
+
+    VCF_parsing_event start_parsing_gt_row()
+    {
+        if (state != parsing_genotypes) {
+            // LCOV_EXCL_START
+            if (state != end_of_data_line) {
+                gt_row_output = no_gt_row;
+                assert(false &&
+                        "parse_genotype_format must be called before "
+                        "parse_gt_row");
+                return invalid_call_order_error();
+            }
+            // LCOV_EXCL_STOP
+            return end_gt_row();
+        }
+
+        current_genotype_value_index = 0;
+
+        // UINT_MAX if the key is not in the FORMAT field.
+        if (gt_row_output < dosage_float_row) {
+            row_key_position = format_plan->gt - 1;
+        } else {
+            const std::vector<std::string>& keys = format_plan->keys;
+            const auto key_iter =
+                    std::find(keys.begin(), keys.end(), dosage_row_key);
+            row_key_position = key_iter != keys.end() ?
+                    (unsigned) (key_iter - keys.begin()) :
+                    UINT_MAX;
+        }
+
+        // Without GT values, no genotype matches the predicate.
+        if (gt_row_output == gt_predicate_row && row_key_position == UINT_MAX) {
+            return end_gt_row();
+        }
+
+        if (!selected_samples.empty()) {
+            if (current_output_sample >= selected_samples.size()) {
+                return end_gt_row();
+            }
+            genotype_columns_to_skip =
+                    selected_samples[current_output_sample] -
+                    current_genotype_field_index;
+        }
+
+        return continue_parsing_gt_row();
+    }
+
+    bool select_samples_impl(const std::vector<std::string>& sample_ids)
+    {
+        // LCOV_EXCL_START
+        if (vcf_header == nullptr) {
+            assert(false && "The header must be parsed first");
+            return false;
+        }
+        // LCOV_EXCL_STOP
+
+        // An empty selection would mean all samples.
+        if (sample_ids.empty()) {
+            return false;
+        }
+
+        // The values are set to true when the IDs are found.
+        // Repeated IDs are merged.
+        std::unordered_map<std::string, bool> requested_ids;
+        for (const std::string& sample_id : sample_ids) {
+            requested_ids.emplace(sample_id, false);
+        }
+
+        std::vector<unsigned> sample_indices;
+        size_t number_of_found_ids = 0;
+
+        for (unsigned i = 0; i < number_of_sample_ids; ++i) {
+            const auto it = requested_ids.find(vcf_header->sample_ids[i]);
+            if (it != requested_ids.end()) {
+                sample_indices.push_back(i);
+                if (!it->second) {
+                    it->second = true;
+                    ++number_of_found_ids;
+                }
+            }
+        }
+
+        if (number_of_found_ids < requested_ids.size()) {
+            return false;
+        }
+
+        selected_samples.swap(sample_indices);
+        return true;
+    }
+
+    bool select_samples_impl(const std::vector<unsigned>& sample_indices)
+    {
+        if (sample_indices.empty()) {
+            return false;
+        }
+        for (unsigned index : sample_indices) {
+            if (index >= number_of_sample_ids) {
+                return false;
+            }
+        }
+
+        selected_samples = sample_indices;
+        std::sort(selected_samples.begin(), selected_samples.end());
+        selected_samples.erase(
+                std::unique(selected_samples.begin(), selected_samples.end()),
+                selected_samples.end());
+        return true;
+    }
+
+    VCF_parsing_event index_genotypes_impl()
+    {
+        genotype_column_offsets.clear();
+
+        if (state == end_of_data_line) {
+            genotypes_indexed = true;
+            return VCF_parsing_event::ok;
+        }
+
+        // LCOV_EXCL_START
+        if (state != parsing_genotypes || current_genotype_field_index != 0) {
+            assert(false &&
+                    "index_genotypes must be called right after "
+                    "parse_genotype_format");
+            return invalid_call_order_error();
+        }
+        // LCOV_EXCL_STOP
+
+        state = indexing_genotypes;
+
+        return continue_indexing_genotypes();
+    }
+
+    VCF_parsing_event parse_genotype_of_impl(unsigned sample_index)
+    {
+        // LCOV_EXCL_START
+        if (!genotypes_indexed) {
+            assert(false &&
+                    "index_genotypes must be called before "
+                    "parse_genotype_of");
+            return invalid_call_order_error();
+        }
+        if (sample_index >= number_of_sample_ids) {
+            assert(false && "Sample index is out of range");
+            return invalid_call_order_error();
+        }
+        // LCOV_EXCL_STOP
+
+        reset_genotype_captures();
+
+        // Lines can be shorter than the header line.
+        if (sample_index >= get_number_of_indexed_genotypes_impl()) {
+            return VCF_parsing_event::ok;
+        }
+
+        return decode_genotype_column(
+                indexed_genotypes + genotype_column_offsets[sample_index],
+                indexed_genotypes + genotype_column_offsets[sample_index + 1] -
+                        1);
+    }
+
+    unsigned get_number_of_indexed_genotypes_impl() const
+    {
+        return genotype_column_offsets.empty() ?
+                0 :
+                (unsigned) genotype_column_offsets.size() - 1;
+    }
+
+    bool genotype_available_impl() const
+    {
+        return tokenizer.get_terminator() == '\t' &&
+                (selected_samples.empty() ||
+                        current_output_sample < selected_samples.size());
+    }
+
     VCF_parsing_event clear_line_impl()
     {
         if (!tokenizer.at_eof()) {
@@ -288,9 +801,12 @@ protected:
         parsing_info_field,
         parsing_genotype_format,
         parsing_genotypes,
+        indexing_genotypes,
         end_of_data_line,
         skipping_to_next_line,
-        peeking_beyond_newline
+        peeking_beyond_newline,
+        parsing_record,
+        parsing_batch
     };
     int state = not_parsing;
 
@@ -355,7 +871,9 @@ protected:
     union {
         VCF_header* header;
         struct {
+            // Either 'chrom' or 'contig_id' is set.
             std::string* chrom;
+            unsigned* contig_id;
             unsigned* pos;
         } loc;
         std::vector<std::string>* ids;
@@ -363,42 +881,130 @@ protected:
             std::string* ref;
             std::vector<std::string>* alts;
         } alleles;
-        std::string* quality;
+        struct {
+            // Either 'text' or 'value' is set.
+            std::string* text;
+            float* value;
+        } quality;
         std::vector<std::string>* filters;
+        VCF_id_set* filter_ids;
+        VCF_record_impl* record;
+        VCF_record_batch_impl* batch;
     } output;
 
-    bool alleles_parsed;
-    unsigned number_of_alts;
-    std::vector<std::string> info;
+    // Contig IDs returned by parse_loc() and parse_batch().
+    // The contigs declared in the header come first.
+    VCF_dictionary contig_dictionary;
 
-    void reset_state_for_next_data_line()
+    // Filter IDs starting with PASS and the filters
+    // declared in the header.
+    VCF_dictionary filter_dictionary;
+
+    // The keys of the INFO flags starting with the
+    // flags declared in the header.
+    VCF_dictionary info_flag_dictionary;
+
+    // Seeds the dictionaries with the names declared in the header.
+    // The names of the previous header, if any, are discarded, so
+    // that the IDs always match the positions of the declarations.
+    void load_dictionaries()
     {
-        state = parsing_chrom;
-        alleles_parsed = false;
+        contig_dictionary.clear();
+        filter_dictionary.clear();
+        info_flag_dictionary.clear();
+        last_batch_filters.clear();
+        last_batch_filter_ids.clear();
+
+        for (const VCF_contig& contig : vcf_header->contigs) {
+            contig_dictionary.get_id(contig.id.data(), contig.id.length());
+        }
+
+        filter_dictionary.get_id("PASS", 4);
+        for (const VCF_filter& filter : vcf_header->filters) {
+            filter_dictionary.get_id(filter.id.data(), filter.id.length());
+        }
+
+        // Keys can be redeclared with a different type.
+        for (const std::string& key : vcf_header->info_flag_keys) {
+            if (vcf_header->info_definitions.at(key).data_type ==
+                    VCF_key_definition::flag_type) {
+                info_flag_dictionary.get_id(key.data(), key.length());
+            }
+        }
     }
 
-    // TODO Implement the INFO and FORMAT type definitions in the header.
-    std::set<std::string> format_keys;
+    // Whether parse_filters() was called with a VCF_id_set.
+    bool filters_as_ids;
 
-    struct Strcmp {
-        bool operator()(const char* left, const char* right) const
-        {
-            return strcmp(left, right) < 0;
+    // The FILTER value of the previous record added to a batch
+    // and its filter IDs.
+    std::string last_batch_filters;
+    std::vector<unsigned> last_batch_filter_ids;
+
+    // The variable passed to capture_info_flags().
+    VCF_id_set* info_flags = nullptr;
+
+    void add_info_flag(const char* key, size_t key_len)
+    {
+        if (!VCF_record_impl::is_dot(key, key + key_len)) {
+            info_flags->insert(info_flag_dictionary.get_id(key, key_len));
         }
-    };
+    }
 
-    // Positions of the reserved genotype keys in the FORMAT field.
-    struct Genotype_key_positions {
-        unsigned number_of_positions;
-        unsigned gt;
-        std::map<const char*, unsigned, Strcmp> other_keys;
+    // Stores CHROM into the variable passed to parse_loc().
+    VCF_parsing_event parse_chrom()
+    {
+        const char* chrom;
+        size_t chrom_len;
 
-        void clear()
-        {
-            gt = number_of_positions = 0;
-            other_keys.clear();
+        if (!tokenizer.prepare_token_view_or_accumulate(
+                    tokenizer.find_newline_or_tab(), &chrom, &chrom_len)) {
+            return VCF_parsing_event::need_more_data;
         }
-    } genotype_key_positions;
+        if (tokenizer.at_eol()) {
+            return missing_mandatory_field_error(parsing_pos - parsing_chrom);
+        }
+
+        if (output.loc.chrom != nullptr) {
+            output.loc.chrom->assign(chrom, chrom_len);
+        } else {
+            *output.loc.contig_id = contig_dictionary.get_id(chrom, chrom_len);
+        }
+
+        state = parsing_pos;
+        return VCF_parsing_event::ok;
+    }
+
+    // The number of tabs that remain to be found
+    // before the end of the INFO field.
+    unsigned record_tabs_to_find;
+
+    // The maximum number of records in the batch
+    // that is being filled by parse_batch().
+    size_t batch_size;
+
+    enum Batch_line_state {
+        batch_line_start,
+        batch_mandatory_fields,
+        batch_rest_of_line
+    } batch_line_state;
+
+    bool alleles_parsed;
+    unsigned number_of_alts;
+    std::vector<std::string> info;
+
+    // Buffers of the list elements that are not currently in use.
+    VCF_string_pool string_pool;
+
+    void reset_state_for_next_data_line()
+    {
+        state = parsing_chrom;
+        gt_row_output = no_gt_row;
+        genotype_values.clear();
+        alleles_parsed = false;
+        sample_ploidy = 0;
+        genotypes_indexed = false;
+    }
 
     enum Data_type {
         vcf_integer,
@@ -418,13 +1024,19 @@ protected:
         exact_number
     };
 
-    struct Genotype_value {
+    // A variable supplied by the client code to receive
+    // a decoded INFO or FORMAT value.
+    struct Value_capture {
         Data_type data_type;
-        unsigned number_of_values;
+        bool vector;
+        // Definition of the key from the header or nullptr.
+        const VCF_key_definition* definition;
         union {
             bool* flag;
             int* int_scalar;
             std::vector<int>* int_vector;
+            float* float_scalar;
+            std::vector<float>* float_vector;
             std::string* string_scalar;
             std::vector<std::string>* string_vector;
             char* char_scalar;
@@ -432,33 +1044,689 @@ protected:
         };
     };
 
+    typedef Value_capture Genotype_value;
+
+    // Decoding plan compiled from the FORMAT field of a data line.
+    struct Format_plan {
+        // The FORMAT field the plan was compiled from.
+        std::string format;
+        // Genotype keys in the order of their appearance.
+        std::vector<std::string> keys;
+        // One plus the position of the GT key or zero if there is none.
+        unsigned gt;
+    };
+
+    // Files typically use only a few distinct FORMAT fields, so the
+    // plans are cached and looked up by comparing the raw FORMAT text.
+    static constexpr size_t max_format_plans = 16;
+    std::vector<std::unique_ptr<Format_plan>> format_plans;
+    size_t next_replaced_format_plan = 0;
+
+    // The plan for the current data line.
+    Format_plan* format_plan = nullptr;
+
+    // Capture bindings for the keys of the FORMAT field of the
+    // current data line by position. Empty until the FORMAT field
+    // of the line has been parsed.
+    std::vector<Genotype_value> genotype_values;
+
+    Format_plan* find_format_plan(const char* format, size_t format_len)
+    {
+        if (format_plan != nullptr &&
+                format_plan->format.length() == format_len &&
+                memcmp(format_plan->format.data(), format, format_len) == 0) {
+            return format_plan;
+        }
+
+        for (const auto& plan : format_plans) {
+            if (plan->format.length() == format_len &&
+                    memcmp(plan->format.data(), format, format_len) == 0) {
+                return plan.get();
+            }
+        }
+
+        return compile_format_plan(format, format_len);
+    }
+
+    Format_plan* compile_format_plan(const char* format, size_t format_len)
+    {
+        Format_plan* plan;
+
+        if (format_plans.size() < max_format_plans) {
+            format_plans.emplace_back(new Format_plan);
+            plan = format_plans.back().get();
+        } else {
+            plan = format_plans[next_replaced_format_plan].get();
+            next_replaced_format_plan =
+                    (next_replaced_format_plan + 1) % max_format_plans;
+        }
+
+        plan->format.assign(format, format_len);
+        plan->keys.clear();
+        plan->gt = 0;
+
+        const char* const format_end = format + format_len;
+
+        for (;;) {
+            const char* key_end = (const char*) memchr(
+                    format, ':', (size_t) (format_end - format));
+            if (key_end == nullptr) {
+                key_end = format_end;
+            }
+            plan->keys.emplace_back(format, key_end);
+            if (plan->keys.back() == "GT") {
+                if (plan->keys.size() != 1) {
+                    // TODO Generate a warning: GT must be the first key.
+                }
+                plan->gt = (unsigned) plan->keys.size();
+            }
+            if (key_end == format_end) {
+                break;
+            }
+            format = key_end + 1;
+        }
+
+        return plan;
+    }
+
+
+    // The header of the file being parsed.
+    const VCF_header* vcf_header = nullptr;
+
+    // Captured INFO keys. The captures remain in effect for
+    // all subsequent data lines.
+    std::map<std::string, Value_capture> info_captures;
+
+    // Open-addressing hash table that indexes 'info_captures'.
+    // Rebuilt every time a capture is added, so that keys can be
+    // looked up directly in the input buffer while parsing.
+    struct Info_key_index {
+        struct Slot {
+            const std::string* key;
+            Value_capture* capture;
+        };
+        std::vector<Slot> slots;
+
+        // FNV-1a
+        static size_t hash(const char* key, size_t key_len)
+        {
+            uint32_t h = 2166136261U;
+            while (key_len-- > 0) {
+                h = (h ^ (unsigned char) *key++) * 16777619U;
+            }
+            return h;
+        }
+
+        void rebuild(std::map<std::string, Value_capture>& captures)
+        {
+            // Keep the load factor at or below one half.
+            size_t size = 8;
+            while (size < captures.size() * 2) {
+                size *= 2;
+            }
+            slots.assign(size, Slot{nullptr, nullptr});
+
+            for (auto& key_and_capture : captures) {
+                const std::string& key = key_and_capture.first;
+                size_t i = hash(key.data(), key.length());
+                while (slots[i &= size - 1].key != nullptr) {
+                    ++i;
+                }
+                slots[i].key = &key;
+                slots[i].capture = &key_and_capture.second;
+            }
+        }
+
+        Value_capture* find(const char* key, size_t key_len) const
+        {
+            if (slots.empty()) {
+                return nullptr;
+            }
+            const size_t mask = slots.size() - 1;
+            for (size_t i = hash(key, key_len);; ++i) {
+                const Slot& slot = slots[i & mask];
+                if (slot.key == nullptr) {
+                    return nullptr;
+                }
+                if (slot.key->length() == key_len &&
+                        memcmp(slot.key->data(), key, key_len) == 0) {
+                    return slot.capture;
+                }
+            }
+        }
+    } info_key_index;
+
+    // Whether the INFO fields are stored in 'info'
+    // ('parse_info()') or only decoded into captured
+    // variables ('parse_captured_info()').
+    bool keep_info_fields = true;
+
+    enum Info_key_state {
+        parsing_info_key,
+        parsing_info_value,
+        skipping_info_value
+    } info_key_state = parsing_info_key;
+
+    // The captured key whose value is being parsed.
+    Value_capture* current_info_capture = nullptr;
+
+    // Sets the captured variable to the absent value.
+    void reset_capture(const Value_capture& capture)
+    {
+        if (capture.vector) {
+            switch (capture.data_type) {
+            case vcf_integer:
+            case vcf_gt:
+                capture.int_vector->clear();
+                break;
+            case vcf_float:
+                capture.float_vector->clear();
+                break;
+            default /* vcf_string */:
+                string_pool.truncate(capture.string_vector, 0);
+            }
+        } else {
+            switch (capture.data_type) {
+            case vcf_flag:
+                *capture.flag = false;
+                break;
+            case vcf_integer:
+                *capture.int_scalar = VCF_missing_int;
+                break;
+            case vcf_float:
+                *capture.float_scalar = VCF_missing_float;
+                break;
+            default /* vcf_string */:
+                capture.string_scalar->clear();
+            }
+        }
+    }
+
+    // Marks all captured INFO keys as absent.
+    void reset_info_captures()
+    {
+        for (const auto& key_and_capture : info_captures) {
+            reset_capture(key_and_capture.second);
+        }
+    }
+
+    static bool is_missing_value(const char* ptr, const char* end)
+    {
+        return end - ptr == 1 && *ptr == '.';
+    }
+
+    // Parses a decimal integer that occupies the entire range.
+    static bool parse_int_value(const char* ptr, const char* end, int* value)
+    {
+        if (is_missing_value(ptr, end)) {
+            *value = VCF_missing_int;
+            return true;
+        }
+
+        bool negative = false;
+        if (ptr < end && (*ptr == '-' || *ptr == '+')) {
+            negative = *ptr++ == '-';
+        }
+        if (ptr == end) {
+            return false;
+        }
+
+        // VCF_missing_int itself cannot be represented.
+        const unsigned limit = (unsigned) INT_MAX;
+        unsigned number = 0, digit;
+
+        do {
+            if ((digit = (unsigned) *ptr - '0') > 9) {
+                return false;
+            }
+            if (number > limit / 10 ||
+                    (number == limit / 10 && digit > limit % 10)) {
+                return false;
+            }
+            number = number * 10 + digit;
+        } while (++ptr < end);
+
+        *value = negative ? -(int) number : (int) number;
+        return true;
+    }
+
+    // Parses a comma-separated list of integers that occupies the
+    // entire range and appends the numbers to 'values'. Lists like
+    // AD and PL consist mostly of short unsigned numbers, which are
+    // converted in the same pass that finds the commas: eight bytes
+    // at a time where the range allows it, one byte at a time near
+    // its end. Other values are passed to parse_int_value(). Returns
+    // the number of values or UINT_MAX if any of them is invalid.
+    static unsigned parse_int_list(
+            const char* ptr, const char* end, std::vector<int>* values)
+    {
+        unsigned number_of_values = 0;
+
+        for (;;) {
+            ++number_of_values;
+
+            unsigned len = 0;
+            unsigned number = 0;
+
+            if (end - ptr >= 8) {
+                // The first byte goes to the least significant position
+                // regardless of the byte order of the platform. Compilers
+                // turn this loop into a single load where they can.
+                uint64_t word = 0;
+                for (int i = 7; i >= 0; --i) {
+                    word = word << 8 | (unsigned char) ptr[i];
+                }
+
+                // Replace each digit with its value and find the
+                // bytes that are not digits.
+                word ^= 0x3030303030303030ULL;
+                const uint64_t non_digits =
+                        (((word & 0x7F7F7F7F7F7F7F7FULL) +
+                                 0x7676767676767676ULL) |
+                                word) &
+                        0x8080808080808080ULL;
+
+                // The index of the first non-digit byte: the multiplier
+                // moves its own byte '7 - index', which holds 'index',
+                // into the most significant byte.
+                len = non_digits == 0 ?
+                        8 :
+                        (unsigned) ((((non_digits & (0 - non_digits)) >> 7) *
+                                            0x0001020304050607ULL) >>
+                                56);
+
+                if (len > 0) {
+                    // Move the digits to the most significant bytes
+                    // and combine pairs of bytes, pairs of pairs, and
+                    // pairs of quadruples.
+                    word <<= 8 * (8 - len);
+                    word = (word * (10 * 256 + 1)) >> 8;
+                    word = ((word & 0x00FF00FF00FF00FFULL) *
+                                   (100 * 65536 + 1)) >>
+                            16;
+                    number = (unsigned) (((word & 0x0000FFFF0000FFFFULL) *
+                                                 ((uint64_t) 10000 << 32 |
+                                                         1)) >>
+                            32);
+                }
+            } else {
+                unsigned digit;
+                while (ptr + len < end &&
+                        (digit = (unsigned) ptr[len] - '0') <= 9 &&
+                        len < 8) {
+                    number = number * 10 + digit;
+                    ++len;
+                }
+            }
+
+            const char* const value_end = ptr + len;
+
+            // Longer numbers, signs, and missing values
+            // are left to parse_int_value().
+            if (len > 0 && len < 8 &&
+                    (value_end == end || *value_end == ',')) {
+                values->push_back((int) number);
+            } else {
+                const char* const comma =
+                        (const char*) memchr(ptr, ',', end - ptr);
+
+                values->push_back(0);
+                if (!parse_int_value(ptr, comma == nullptr ? end : comma,
+                            &values->back())) {
+                    return UINT_MAX;
+                }
+                ptr = comma == nullptr ? end : comma;
+                if (ptr == end) {
+                    return number_of_values;
+                }
+                ++ptr;
+                continue;
+            }
+
+            if (value_end == end) {
+                return number_of_values;
+            }
+            ptr = value_end + 1;
+        }
+    }
+
+    // Returns the number of values expected for the key or
+    // UINT_MAX if the number cannot be determined.
+    unsigned get_expected_number_of_values(
+            const VCF_key_definition& definition) const
+    {
+        switch (definition.number_of_values) {
+        case VCF_key_definition::exact_number:
+            return definition.number;
+        case VCF_key_definition::one_per_alt:
+            return alleles_parsed ? number_of_alts : UINT_MAX;
+        case VCF_key_definition::one_per_allele:
+            return alleles_parsed ? number_of_alts + 1 : UINT_MAX;
+        case VCF_key_definition::one_per_genotype:
+            // The number of genotypes is known only for haploid
+            // and diploid samples whose GT has already been parsed.
+            if (!alleles_parsed) {
+                return UINT_MAX;
+            }
+            switch (sample_ploidy) {
+            case 1:
+                return number_of_alts + 1;
+            case 2:
+                return (number_of_alts + 1) * (number_of_alts + 2) / 2;
+            }
+            return UINT_MAX;
+        default:
+            return UINT_MAX;
+        }
+    }
+
+    // Decodes a value or a comma-separated list of values into
+    // the captured variable. Returns an error message or nullptr.
+    const char* decode_value(
+            const Value_capture& capture, const char* ptr, const char* end)
+    {
+        if (!capture.vector) {
+            switch (capture.data_type) {
+            case vcf_integer:
+                if (!parse_int_value(ptr, end, capture.int_scalar)) {
+                    return "Invalid integer value";
+                }
+                break;
+            case vcf_float:
+                if (!VCF_float_parser::parse(
+                            ptr, end, capture.float_scalar)) {
+                    return "Invalid floating-point value";
+                }
+                break;
+            default /* vcf_string */:
+                if (is_missing_value(ptr, end)) {
+                    capture.string_scalar->clear();
+                } else {
+                    capture.string_scalar->assign(ptr, end - ptr);
+                }
+            }
+            return nullptr;
+        }
+
+        // A single missing value stands for the entire list.
+        if (is_missing_value(ptr, end)) {
+            return nullptr;
+        }
+
+        size_t number_of_values = 0;
+
+        if (capture.data_type == vcf_integer) {
+            number_of_values = parse_int_list(ptr, end, capture.int_vector);
+            if (number_of_values == UINT_MAX) {
+                return "Invalid integer value";
+            }
+        } else {
+            for (;;) {
+                const char* value_end =
+                        (const char*) memchr(ptr, ',', end - ptr);
+                if (value_end == nullptr) {
+                    value_end = end;
+                }
+
+                if (capture.data_type == vcf_float) {
+                    capture.float_vector->push_back(0);
+                    if (!VCF_float_parser::parse(ptr, value_end,
+                                &capture.float_vector->back())) {
+                        return "Invalid floating-point value";
+                    }
+                } else {
+                    string_pool.set(capture.string_vector,
+                            capture.string_vector->size(), ptr,
+                            value_end - ptr);
+                }
+
+                ++number_of_values;
+
+                if (value_end == end) {
+                    break;
+                }
+                ptr = value_end + 1;
+            }
+        }
+
+        if (capture.definition != nullptr) {
+            const unsigned expected =
+                    get_expected_number_of_values(*capture.definition);
+            if (expected != UINT_MAX && expected != number_of_values) {
+                return "Unexpected number of values";
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Checks if a variable of the specified type can
+    // receive the values of the declared key.
+    static bool is_compatible_definition(const VCF_key_definition& definition,
+            Data_type data_type, bool vector)
+    {
+        switch (data_type) {
+        case vcf_flag:
+            if (definition.data_type != VCF_key_definition::flag_type) {
+                return false;
+            }
+            break;
+        case vcf_integer:
+            if (definition.data_type != VCF_key_definition::integer_type) {
+                return false;
+            }
+            break;
+        case vcf_float:
+            if (definition.data_type != VCF_key_definition::float_type &&
+                    definition.data_type != VCF_key_definition::integer_type) {
+                return false;
+            }
+            break;
+        default /* vcf_string */:
+            if (definition.data_type == VCF_key_definition::flag_type) {
+                return false;
+            }
+        }
+
+        // Scalar variables can only receive single-valued keys.
+        return vector || data_type == vcf_flag ||
+                (definition.number_of_values ==
+                                VCF_key_definition::exact_number &&
+                        definition.number == 1);
+    }
+
+    Value_capture* capture_info_value(
+            const char* key, Data_type data_type, bool vector)
+    {
+        // LCOV_EXCL_START
+        if (vcf_header == nullptr) {
+            assert(false && "VCF header must be parsed first");
+            return nullptr;
+        }
+        // LCOV_EXCL_STOP
+
+        auto definition_iter = vcf_header->info_definitions.find(key);
+        if (definition_iter == vcf_header->info_definitions.end()) {
+            return nullptr;
+        }
+        const VCF_key_definition& definition = definition_iter->second;
+
+        if (!is_compatible_definition(definition, data_type, vector)) {
+            return nullptr;
+        }
+
+        Value_capture& capture = info_captures[key];
+        capture.data_type = data_type;
+        capture.vector = vector;
+        capture.definition = &definition;
+        info_key_index.rebuild(info_captures);
+        return &capture;
+    }
+
+    template <typename T>
+    bool capture_info_impl(const char* key, Data_type data_type, bool vector,
+            T* Value_capture::*member, T* variable)
+    {
+        Value_capture* capture = capture_info_value(key, data_type, vector);
+        if (capture == nullptr) {
+            return false;
+        }
+        capture->*member = variable;
+        return true;
+    }
+
+    template <typename T>
+    bool capture_format_impl(const char* key, Data_type data_type,
+            bool vector, T* Value_capture::*member, T* variable)
+    {
+        if (genotype_values.empty()) {
+            return false;
+        }
+        const std::vector<std::string>& keys = format_plan->keys;
+        const auto key_iter = std::find(keys.begin(), keys.end(), key);
+        if (key_iter == keys.end() || *key_iter == "GT") {
+            return false;
+        }
+
+        // Keys without a '##FORMAT' definition are decoded as
+        // requested, but the number of values is not checked.
+        const VCF_key_definition* definition = nullptr;
+        if (vcf_header != nullptr) {
+            auto definition_iter = vcf_header->format_definitions.find(key);
+            if (definition_iter != vcf_header->format_definitions.end()) {
+                definition = &definition_iter->second;
+                if (!is_compatible_definition(
+                            *definition, data_type, vector)) {
+                    return false;
+                }
+            }
+        }
+
+        Genotype_value* value =
+                &genotype_values[(size_t) (key_iter - keys.begin())];
+        value->data_type = data_type;
+        value->vector = vector;
+        value->definition = definition;
+        value->*member = variable;
+        return true;
+    }
+
+    // Marks the values of all captured FORMAT keys as absent.
+    // Keys that are missing at the end of a genotype field
+    // remain in that state.
+    void reset_genotype_captures()
+    {
+        for (const Genotype_value& value : genotype_values) {
+            if (value.flag != nullptr) {
+                reset_capture(value);
+            }
+        }
+        sample_ploidy = 0;
+    }
+
+    VCF_parsing_event genotype_value_error(const char* err_msg)
+    {
+        return parsing_error(std::string(err_msg) + " of FORMAT key '" +
+                format_plan->keys[current_genotype_value_index] + "'");
+    }
+
     unsigned current_genotype_field_index;
 
     unsigned current_genotype_value_index;
-    std::vector<Genotype_value> genotype_values;
 
     std::vector<int> gt;
     bool phased_gt;
 
-    void reset_genotype_values()
+    // The number of alleles in the GT value of the current
+    // sample or zero if GT has not been parsed.
+    size_t sample_ploidy = 0;
+
+    // Destination of the values decoded by 'parse_gt_row()' and
+    // the other methods that decode a key for all samples at once.
+    // The GT outputs come first.
+    enum Gt_row_output {
+        no_gt_row,
+        gt_matrix_row,
+        gt_packed_row,
+        gt_allele_counts,
+        gt_sparse_row,
+        gt_predicate_row,
+        dosage_float_row,
+        dosage_fixed_row
+    } gt_row_output = no_gt_row;
+
+    // The position of the decoded key in the FORMAT field.
+    unsigned row_key_position;
+
+    int8_t* gt_row_alleles;
+    uint8_t* gt_row_phasing;
+    unsigned gt_row_ploidy;
+
+    uint8_t* gt_row_packed;
+    VCF_multiallelic_policy multiallelic_policy;
+
+    VCF_allele_counts* gt_row_counts;
+
+    VCF_gt_predicate gt_predicate;
+    bool* gt_predicate_result;
+    unsigned gt_predicate_count;
+
+    VCF_sparse_gt_row* gt_row_sparse;
+    // The first sample that has not been listed as missing
+    // or found to have a GT value.
+    unsigned next_sparse_sample;
+
+    const char* dosage_row_key;
+    float* dosage_row_floats;
+    uint16_t* dosage_row_fixed;
+    unsigned dosage_row_width;
+
+    // Indices of the samples chosen by 'select_samples()' in the
+    // order of the genotype columns or empty if all samples are
+    // selected.
+    std::vector<unsigned> selected_samples;
+    // Position of the current sample among the selected samples
+    // (or among all samples if none are selected), which is also
+    // its index in the output of 'parse_gt_row()' and similar
+    // methods.
+    unsigned current_output_sample;
+    // The number of unselected genotype columns yet to be skipped
+    // before the next selected one.
+    unsigned genotype_columns_to_skip = 0;
+
+    // Start offsets of the genotype columns of the current line
+    // relative to 'indexed_genotypes', followed by the offset of
+    // the character after the end of the line.
+    std::vector<size_t> genotype_column_offsets;
+    const char* indexed_genotypes;
+    bool genotypes_indexed = false;
+
+    unsigned get_number_of_output_samples() const
     {
-        memset(genotype_values.data(), 0,
-                (char*) &*genotype_values.end() -
-                        (char*) genotype_values.data());
-        current_genotype_field_index = 0;
-        number_len = 0;
+        return selected_samples.empty() ? number_of_sample_ids :
+                                          (unsigned) selected_samples.size();
     }
 
-    Genotype_value* alloc_genotype_value(unsigned index)
+    // Skips the unselected genotype columns in front of the next
+    // selected sample. Returns false if more data is needed. If
+    // the line ends before that sample, the state changes to
+    // 'end_of_data_line'.
+    bool skip_genotype_columns()
     {
-        if (genotype_values.size() <= index) {
-            size_t old_size = genotype_values.size();
-            genotype_values.resize(index + 1);
-            char* new_struct_ptr = (char*) (genotype_values.data() + old_size);
-            memset(new_struct_ptr, 0,
-                    (char*) &*genotype_values.end() - (char*) new_struct_ptr);
+        const unsigned columns_to_skip = genotype_columns_to_skip;
+
+        if (!tokenizer.skip_tabs(&genotype_columns_to_skip)) {
+            current_genotype_field_index +=
+                    columns_to_skip - genotype_columns_to_skip;
+            return false;
+        }
+        current_genotype_field_index +=
+                columns_to_skip - genotype_columns_to_skip;
+        genotype_columns_to_skip = 0;
+        if (tokenizer.at_eol()) {
+            state = end_of_data_line;
         }
-        return genotype_values.data() + index;
+        return true;
     }
 
     VCF_parsing_event parse_string(State target_state)
@@ -488,15 +1756,12 @@ protected:
                         target_state - parsing_chrom);
             }
             if (!tokenizer.token_is_dot()) {
-                if (next_list_index < container.size()) {
-                    container.at(next_list_index) = tokenizer.get_token();
-                } else {
-                    container.push_back(tokenizer.get_token());
-                }
-                ++next_list_index;
+                const VCF_string_view& token = tokenizer.get_token();
+                string_pool.set(&container, next_list_index++, token.data(),
+                        token.length());
             }
         } while (tokenizer.get_terminator() != '\t');
-        container.resize(next_list_index);
+        string_pool.truncate(&container, next_list_index);
         state = target_state;
         return VCF_parsing_event::ok;
     }
@@ -653,6 +1918,8 @@ protected:
         }
 
     end_of_header_line:
+        load_dictionaries();
+
         if (tokenizer.buffer_is_empty() && !tokenizer.at_eof()) {
             state = peeking_beyond_newline;
             return VCF_parsing_event::need_more_data;
@@ -686,6 +1953,174 @@ protected:
         return VCF_parsing_event::ok;
     }
 
+    VCF_parsing_event continue_parsing_record()
+    {
+        const char* fields;
+        size_t fields_len;
+
+        if (!tokenizer.prepare_token_view_or_accumulate(
+                    tokenizer.find_nth_tab_or_newline(&record_tabs_to_find),
+                    &fields, &fields_len)) {
+            return VCF_parsing_event::need_more_data;
+        }
+
+        const unsigned number_of_fields =
+                output.record->assign(fields, fields_len);
+        if (number_of_fields < number_of_mandatory_columns) {
+            return missing_mandatory_field_error(number_of_fields);
+        }
+
+        alleles_parsed = true;
+        number_of_alts = output.record->count_alts();
+
+        state = tokenizer.at_eol() ? end_of_data_line : parsing_genotype_format;
+        return VCF_parsing_event::ok;
+    }
+
+    VCF_parsing_event continue_parsing_batch()
+    {
+        for (;;) {
+            switch (batch_line_state) {
+            case batch_line_start:
+                if (tokenizer.at_eof() ||
+                        output.batch->get_number_of_records_impl() ==
+                                batch_size) {
+                    reset_state_for_next_data_line();
+                    return VCF_parsing_event::ok;
+                }
+                record_tabs_to_find = number_of_mandatory_columns;
+                batch_line_state = batch_mandatory_fields;
+                /* FALL THROUGH */
+            case batch_mandatory_fields:
+                {
+                    const char* fields;
+                    size_t fields_len;
+
+                    if (!tokenizer.prepare_token_view_or_accumulate(
+                                tokenizer.find_nth_tab_or_newline(
+                                        &record_tabs_to_find),
+                                &fields, &fields_len)) {
+                        return VCF_parsing_event::need_more_data;
+                    }
+
+                    const VCF_parsing_event pe =
+                            add_to_batch(fields, fields_len);
+                    if (pe != VCF_parsing_event::ok) {
+                        return pe;
+                    }
+                }
+                batch_line_state = batch_rest_of_line;
+                /* FALL THROUGH */
+            case batch_rest_of_line:
+                if (!tokenizer.at_eol() &&
+                        !tokenizer.skip_token(tokenizer.find_newline())) {
+                    return VCF_parsing_event::need_more_data;
+                }
+                batch_line_state = batch_line_start;
+                // Make sure that at_eof() returns true after
+                // the last line has been parsed.
+                if (tokenizer.buffer_is_empty() && !tokenizer.at_eof()) {
+                    return VCF_parsing_event::need_more_data;
+                }
+            }
+        }
+    }
+
+    // Splits the mandatory fields of a data line and
+    // appends their values to the batch.
+    VCF_parsing_event add_to_batch(const char* fields, size_t fields_len)
+    {
+        const char* field_ptrs[number_of_mandatory_columns + 1];
+        const char* const end = fields + fields_len;
+
+        unsigned number_of_fields = 0;
+        field_ptrs[0] = fields;
+
+        while (++number_of_fields < number_of_mandatory_columns) {
+            const char* const tab = (const char*) memchr(
+                    field_ptrs[number_of_fields - 1], '\t',
+                    end - field_ptrs[number_of_fields - 1]);
+            if (tab == nullptr) {
+                return missing_mandatory_field_error(number_of_fields);
+            }
+            field_ptrs[number_of_fields] = tab + 1;
+        }
+        // Pretend that the last field is followed by a tab.
+        field_ptrs[number_of_mandatory_columns] = end + 1;
+
+        // Field lengths.
+        size_t len[number_of_mandatory_columns];
+        for (unsigned i = 0; i < number_of_mandatory_columns; ++i) {
+            len[i] = field_ptrs[i + 1] - 1 - field_ptrs[i];
+        }
+
+        // Validate the numeric fields before changing the batch.
+        unsigned pos;
+        if (!VCF_record_impl::parse_pos(field_ptrs[1], len[1], &pos)) {
+            return batch_error(len[1] == 0 ?
+                            "Missing an integer in the POS column" :
+                            "Invalid integer in the POS column");
+        }
+        float quality;
+        if (!VCF_float_parser::parse(
+                    field_ptrs[5], field_ptrs[5] + len[5], &quality)) {
+            return batch_error("Invalid floating-point value in the QUAL "
+                               "column");
+        }
+
+        VCF_record_batch_impl* const batch = output.batch;
+
+        batch->add_record(
+                contig_dictionary.get_id(field_ptrs[0], len[0]), pos);
+        batch->add_text(field_ptrs[2], len[2]);
+        batch->add_text(field_ptrs[3], len[3]);
+        batch->add_text(field_ptrs[4], len[4]);
+        batch->qualities.push_back(quality);
+
+        // Consecutive records tend to have the same FILTER value.
+        if (last_batch_filters.length() == len[6] &&
+                memcmp(last_batch_filters.data(), field_ptrs[6], len[6]) ==
+                        0) {
+            for (unsigned filter_id : last_batch_filter_ids) {
+                batch->add_filter(filter_id);
+            }
+            batch->add_text(field_ptrs[7], len[7]);
+            return VCF_parsing_event::ok;
+        }
+        last_batch_filters.assign(field_ptrs[6], len[6]);
+        last_batch_filter_ids.clear();
+
+        const char* filter = field_ptrs[6];
+        const char* const filters_end = filter + len[6];
+        for (;;) {
+            const char* filter_end =
+                    (const char*) memchr(filter, ';', filters_end - filter);
+            if (filter_end == nullptr) {
+                filter_end = filters_end;
+            }
+            if (!VCF_record_impl::is_dot(filter, filter_end)) {
+                const unsigned filter_id = filter_dictionary.get_id(
+                        filter, filter_end - filter);
+                last_batch_filter_ids.push_back(filter_id);
+                batch->add_filter(filter_id);
+            }
+            if (filter_end == filters_end) {
+                break;
+            }
+            filter = filter_end + 1;
+        }
+
+        batch->add_text(field_ptrs[7], len[7]);
+
+        return VCF_parsing_event::ok;
+    }
+
+    VCF_parsing_event batch_error(const char* err_msg)
+    {
+        state = tokenizer.at_eol() ? end_of_data_line : parsing_genotype_format;
+        return parsing_error(err_msg);
+    }
+
     VCF_parsing_event continue_parsing_ids()
     {
         return parse_string_list(parsing_ref, *output.ids,
@@ -711,10 +2146,18 @@ protected:
         if (pe != VCF_parsing_event::ok) {
             return pe;
         }
-        if (!tokenizer.token_is_dot()) {
-            *output.quality = tokenizer.get_token();
+        if (output.quality.value != nullptr) {
+            const VCF_string_view& token = tokenizer.get_token();
+            if (!VCF_float_parser::parse(token.data(),
+                        token.data() + token.length(),
+                        output.quality.value)) {
+                return parsing_error(
+                        "Invalid floating-point value in the QUAL column");
+            }
+        } else if (!tokenizer.token_is_dot()) {
+            *output.quality.text = tokenizer.get_token();
         } else {
-            output.quality->clear();
+            output.quality.text->clear();
         }
 
         return VCF_parsing_event::ok;
@@ -722,12 +2165,41 @@ protected:
 
     VCF_parsing_event continue_parsing_filters()
     {
-        return parse_string_list(parsing_info_field, *output.filters,
-                tokenizer.newline_or_tab_or_semicolon);
+        if (!filters_as_ids) {
+            return parse_string_list(parsing_info_field, *output.filters,
+                    tokenizer.newline_or_tab_or_semicolon);
+        }
+
+        const char* filter;
+        size_t filter_len;
+
+        do {
+            if (!tokenizer.prepare_token_view_or_accumulate(
+                        tokenizer.find_char_from_set(
+                                tokenizer.newline_or_tab_or_semicolon),
+                        &filter, &filter_len)) {
+                return VCF_parsing_event::need_more_data;
+            }
+            if (tokenizer.at_eol()) {
+                return missing_mandatory_field_error(
+                        parsing_info_field - parsing_chrom);
+            }
+            if (!VCF_record_impl::is_dot(filter, filter + filter_len)) {
+                output.filter_ids->insert(
+                        filter_dictionary.get_id(filter, filter_len));
+            }
+        } while (tokenizer.get_terminator() != '\t');
+
+        state = parsing_info_field;
+        return VCF_parsing_event::ok;
     }
 
     VCF_parsing_event continue_parsing_info()
     {
+        if (!keep_info_fields) {
+            return continue_parsing_captured_info();
+        }
+
         do {
             if (!tokenizer.prepare_token_or_accumulate(
                         tokenizer.find_char_from_set(
@@ -736,10 +2208,26 @@ protected:
             }
             if (tokenizer.at_eol()) {
                 state = end_of_data_line;
-                return VCF_parsing_event::ok;
             }
             if (!tokenizer.token_is_dot()) {
-                info.push_back(tokenizer.get_token());
+                const VCF_string_view& token = tokenizer.get_token();
+                string_pool.set(
+                        &info, info.size(), token.data(), token.length());
+
+                if (info_flags != nullptr &&
+                        token.find('=') == std::string::npos) {
+                    add_info_flag(token.data(), token.length());
+                }
+
+                if (!info_captures.empty()) {
+                    const VCF_parsing_event pe = capture_info_token();
+                    if (pe != VCF_parsing_event::ok) {
+                        return pe;
+                    }
+                }
+            }
+            if (tokenizer.at_eol()) {
+                return VCF_parsing_event::ok;
             }
         } while (tokenizer.get_terminator() != '\t');
 
@@ -748,42 +2236,177 @@ protected:
         return VCF_parsing_event::ok;
     }
 
-    VCF_parsing_event continue_parsing_genotype_format()
+    // Decodes the current INFO token if its key has been captured.
+    VCF_parsing_event capture_info_token()
     {
-        do {
-            if (!tokenizer.prepare_token_or_accumulate(
-                        tokenizer.find_char_from_set(
-                                tokenizer.newline_or_tab_or_colon))) {
-                return VCF_parsing_event::need_more_data;
+        const VCF_string_view& token = tokenizer.get_token();
+        const char* const token_end = token.data() + token.length();
+
+        const char* value =
+                (const char*) memchr(token.data(), '=', token.length());
+        if (value == nullptr) {
+            value = token_end;
+        }
+
+        const Value_capture* const found_capture =
+                info_key_index.find(token.data(), value - token.data());
+        if (found_capture == nullptr) {
+            return VCF_parsing_event::ok;
+        }
+
+        const Value_capture& capture = *found_capture;
+
+        if (capture.data_type == vcf_flag) {
+            *capture.flag = true;
+            return VCF_parsing_event::ok;
+        }
+
+        // A key without a value is treated as a missing value.
+        if (value == token_end) {
+            return VCF_parsing_event::ok;
+        }
+
+        const char* err_msg = decode_value(capture, value + 1, token_end);
+        if (err_msg != nullptr) {
+            return info_value_error(err_msg, capture);
+        }
+
+        return VCF_parsing_event::ok;
+    }
+
+    VCF_parsing_event info_value_error(
+            const char* err_msg, const Value_capture& capture)
+    {
+        for (const auto& key_and_capture : info_captures) {
+            if (&key_and_capture.second == &capture) {
+                return parsing_error(std::string(err_msg) + " of INFO key '" +
+                        key_and_capture.first + "'");
             }
-            if (tokenizer.at_eol()) {
-                state = end_of_data_line;
-                if (number_of_sample_ids == 0) {
-                    return VCF_parsing_event::ok;
+        }
+        return parsing_error(err_msg); // LCOV_EXCL_LINE
+    }
+
+    // Parses the INFO field without storing it: the keys are
+    // looked up directly in the input buffer, and the values
+    // of the keys that have not been captured are skipped.
+    VCF_parsing_event continue_parsing_captured_info()
+    {
+        const char* token;
+        size_t token_len;
+
+        for (;;) {
+            switch (info_key_state) {
+            case parsing_info_key:
+                if (!tokenizer.prepare_token_view_or_accumulate(
+                            tokenizer.find_char_from_set(
+                                    tokenizer.newline_tab_semicolon_equals),
+                            &token, &token_len)) {
+                    return VCF_parsing_event::need_more_data;
                 }
-                return parsing_error("No genotype information present");
-            }
-            std::string key = tokenizer.get_token();
-            auto key_iter = format_keys.insert(key).first;
-            if (key == "GT") {
-                if (genotype_key_positions.number_of_positions != 0) {
-                    // TODO Generate a warning: GT must be the first key.
+                current_info_capture = info_key_index.find(token, token_len);
+                if (tokenizer.get_terminator() == '=') {
+                    info_key_state = current_info_capture != nullptr ?
+                            parsing_info_value :
+                            skipping_info_value;
+                    continue;
                 }
-                genotype_key_positions.gt =
-                        ++genotype_key_positions.number_of_positions;
-            } else {
-                genotype_key_positions.other_keys[key_iter->c_str()] =
-                        ++genotype_key_positions.number_of_positions;
+                if (tokenizer.at_eol()) {
+                    state = end_of_data_line;
+                }
+                // A key without a value: a flag or a missing value.
+                if (current_info_capture != nullptr &&
+                        current_info_capture->data_type == vcf_flag) {
+                    *current_info_capture->flag = true;
+                }
+                if (info_flags != nullptr) {
+                    add_info_flag(token, token_len);
+                }
+                break;
+
+            case parsing_info_value:
+                if (!tokenizer.prepare_token_view_or_accumulate(
+                            tokenizer.find_char_from_set(
+                                    tokenizer.newline_or_tab_or_semicolon),
+                            &token, &token_len)) {
+                    return VCF_parsing_event::need_more_data;
+                }
+                if (tokenizer.at_eol()) {
+                    state = end_of_data_line;
+                }
+                info_key_state = parsing_info_key;
+                if (current_info_capture->data_type == vcf_flag) {
+                    *current_info_capture->flag = true;
+                } else {
+                    const char* err_msg = decode_value(
+                            *current_info_capture, token, token + token_len);
+                    if (err_msg != nullptr) {
+                        return info_value_error(
+                                err_msg, *current_info_capture);
+                    }
+                }
+                break;
+
+            default /* skipping_info_value */:
+                if (!tokenizer.skip_token(tokenizer.find_char_from_set(
+                            tokenizer.newline_or_tab_or_semicolon))) {
+                    return VCF_parsing_event::need_more_data;
+                }
+                if (tokenizer.at_eol()) {
+                    state = end_of_data_line;
+                }
+                info_key_state = parsing_info_key;
             }
-        } while (tokenizer.get_terminator() != '\t');
 
-        reset_genotype_values();
+            if (tokenizer.at_eol()) {
+                return VCF_parsing_event::ok;
+            }
+            if (tokenizer.get_terminator() == '\t') {
+                state = parsing_genotype_format;
+                return VCF_parsing_event::ok;
+            }
+        }
+    }
+
+    VCF_parsing_event continue_parsing_genotype_format()
+    {
+        const char* format;
+        size_t format_len;
+
+        if (!tokenizer.prepare_token_view_or_accumulate(
+                    tokenizer.find_newline_or_tab(), &format, &format_len)) {
+            return VCF_parsing_event::need_more_data;
+        }
+        if (tokenizer.at_eol()) {
+            state = end_of_data_line;
+            if (number_of_sample_ids == 0) {
+                return VCF_parsing_event::ok;
+            }
+            return parsing_error("No genotype information present");
+        }
+
+        format_plan = find_format_plan(format, format_len);
+        genotype_values.assign(format_plan->keys.size(), Genotype_value());
+
+        current_genotype_field_index = 0;
+        current_output_sample = 0;
+        genotype_columns_to_skip = 0;
+        number_len = 0;
         state = parsing_genotypes;
         return VCF_parsing_event::ok;
     }
 
     VCF_parsing_event continue_parsing_genotype()
     {
+        if (genotype_columns_to_skip > 0) {
+            if (!skip_genotype_columns()) {
+                return VCF_parsing_event::need_more_data;
+            }
+            // The line ends before the selected sample.
+            if (state == end_of_data_line) {
+                return VCF_parsing_event::ok;
+            }
+        }
+
         Genotype_value* value =
                 genotype_values.data() + current_genotype_value_index;
 
@@ -798,9 +2421,11 @@ protected:
                     return VCF_parsing_event::ok;
                 }
             } else {
-                if (!tokenizer.prepare_token_or_accumulate(
-                            tokenizer.find_char_from_set(
-                                    tokenizer.newline_or_tab_or_colon))) {
+                const char* token;
+                size_t token_len;
+
+                if (!prepare_genotype_value(
+                            value->data_type == vcf_gt, &token, &token_len)) {
                     return VCF_parsing_event::need_more_data;
                 }
 
@@ -808,22 +2433,17 @@ protected:
                     state = end_of_data_line;
                 }
 
-                switch (value->data_type) {
-                // TODO case vcf_integer:
-                // TODO case vcf_float:
-                // TODO case vcf_character:
-                // TODO case vcf_string:
-                case vcf_gt:
-                    // Hi
-                    {
-                        const char* err_msg = parse_gt();
-                        if (err_msg != nullptr) {
-                            return parsing_error(err_msg);
-                        }
+                if (value->data_type == vcf_gt) {
+                    const char* err_msg = parse_gt(token, token_len);
+                    if (err_msg != nullptr) {
+                        return parsing_error(err_msg);
+                    }
+                } else {
+                    const char* err_msg =
+                            decode_value(*value, token, token + token_len);
+                    if (err_msg != nullptr) {
+                        return genotype_value_error(err_msg);
                     }
-                    break;
-                default /* vcf_flag - impossible type for genotype info */:
-                    break;
                 }
 
                 if (tokenizer.at_eol()) {
@@ -837,38 +2457,853 @@ protected:
             }
 
             ++value;
-        } while (++current_genotype_value_index <
-                genotype_key_positions.number_of_positions);
+        } while (++current_genotype_value_index < format_plan->keys.size());
 
         return parsing_error("Too many genotype info fields");
     }
 
-    const char* parse_gt()
+    // Extracts the next value from the genotype field without
+    // copying it unless it spans input buffers.
+    bool prepare_genotype_value(
+            bool is_gt, const char** token, size_t* token_len)
     {
-        gt.clear();
+        // Most GT values are three bytes long ('0/1'), so
+        // their terminator is checked without searching.
+        if (is_gt) {
+            const char* const peeked = tokenizer.peek(4);
+            if (peeked != nullptr && is_short_gt_token(peeked)) {
+                *token = peeked;
+                *token_len = 3;
+                return tokenizer.skip_token(peeked + 3);
+            }
+        }
 
-        const std::string& token = tokenizer.get_token();
+        return tokenizer.prepare_token_view_or_accumulate(
+                tokenizer.find_newline_or_tab_or_colon(), token, token_len);
+    }
 
-        size_t len = token.length();
+    VCF_parsing_event continue_indexing_genotypes()
+    {
+        const char* genotypes;
+        size_t genotypes_len;
+
+        if (!tokenizer.prepare_token_view_or_accumulate(
+                    tokenizer.find_newline(), &genotypes, &genotypes_len)) {
+            return VCF_parsing_event::need_more_data;
+        }
+
+        state = end_of_data_line;
+
+        // The offset of each column is stored along with the offset
+        // of the end of the line, so that the boundaries of column 'i'
+        // are 'offsets[i]' and 'offsets[i + 1] - 1'.
+        genotype_column_offsets.push_back(0);
+        VCF_tokenizer::find_tabs(
+                genotypes, genotypes_len, &genotype_column_offsets);
+        genotype_column_offsets.push_back(genotypes_len + 1);
+        for (size_t i = 1; i < genotype_column_offsets.size() - 1; ++i) {
+            ++genotype_column_offsets[i];
+        }
+
+        if (genotype_column_offsets.size() - 1 > number_of_sample_ids) {
+            genotype_column_offsets.clear();
+            return parsing_error(
+                    "The number of genotype fields exceeds "
+                    "the number of samples");
+        }
+
+        indexed_genotypes = genotypes;
+        genotypes_indexed = true;
+        return VCF_parsing_event::ok;
+    }
+
+    // Decodes the values of a genotype field that is entirely in
+    // memory into the captured variables.
+    VCF_parsing_event decode_genotype_column(const char* ptr, const char* end)
+    {
+        const Genotype_value* value = genotype_values.data();
+
+        for (current_genotype_value_index = 0;;) {
+            const char* const colon =
+                    (const char*) memchr(ptr, ':', (size_t) (end - ptr));
+            const char* const value_end = colon != nullptr ? colon : end;
+
+            if (value->flag != nullptr) {
+                if (value->data_type == vcf_gt) {
+                    const char* err_msg = parse_gt(ptr, value_end - ptr);
+                    if (err_msg != nullptr) {
+                        return parsing_error(err_msg);
+                    }
+                } else {
+                    const char* err_msg = decode_value(*value, ptr, value_end);
+                    if (err_msg != nullptr) {
+                        return genotype_value_error(err_msg);
+                    }
+                }
+            }
+
+            if (colon == nullptr) {
+                return VCF_parsing_event::ok;
+            }
+            if (++current_genotype_value_index >= format_plan->keys.size()) {
+                return parsing_error("Too many genotype info fields");
+            }
+            ptr = colon + 1;
+            ++value;
+        }
+    }
+
+    // Parses the genotype fields of the remaining samples
+    // on the line and passes their GT values to the output
+    // selected by 'parse_gt_row()'.
+    VCF_parsing_event continue_parsing_gt_row()
+    {
+        const bool is_gt = gt_row_output < dosage_float_row;
+
+        const char* token;
+        size_t token_len;
+
+        if (genotype_columns_to_skip > 0) {
+            if (!skip_genotype_columns()) {
+                return VCF_parsing_event::need_more_data;
+            }
+            if (state == end_of_data_line) {
+                return end_gt_row();
+            }
+        }
+
+        for (;;) {
+            if (current_genotype_value_index == 0) {
+                if (gt_row_output == gt_sparse_row) {
+                    skip_hom_ref_columns();
+                } else if (gt_row_output == gt_predicate_row) {
+                    skip_hom_ref_columns();
+                    stop_if_gt_predicate_unreachable(current_output_sample);
+                    if (gt_row_output == no_gt_row) {
+                        return VCF_parsing_event::ok;
+                    }
+                }
+            }
+
+            if (current_genotype_value_index == row_key_position) {
+                if (!prepare_genotype_value(is_gt, &token, &token_len)) {
+                    return VCF_parsing_event::need_more_data;
+                }
+                if (tokenizer.at_eol()) {
+                    state = end_of_data_line;
+                }
+                const char* err_msg = store_gt_row_value(token, token_len);
+                if (err_msg != nullptr) {
+                    gt_row_output = no_gt_row;
+                    return parsing_error(err_msg);
+                }
+                // The rest of the line is left for 'clear_line()'.
+                if (gt_row_output == no_gt_row) {
+                    return VCF_parsing_event::ok;
+                }
+            } else {
+                if (!tokenizer.skip_token(
+                            tokenizer.find_newline_or_tab_or_colon())) {
+                    return VCF_parsing_event::need_more_data;
+                }
+                if (tokenizer.at_eol()) {
+                    state = end_of_data_line;
+                }
+            }
+
+            if (tokenizer.at_eol()) {
+                ++current_genotype_field_index;
+                break;
+            }
+
+            if (tokenizer.get_terminator() == '\t') {
+                if (++current_genotype_field_index >= number_of_sample_ids) {
+                    gt_row_output = no_gt_row;
+                    return parsing_error(
+                            "The number of genotype fields exceeds "
+                            "the number of samples");
+                }
+                current_genotype_value_index = 0;
+                ++current_output_sample;
+                if (!selected_samples.empty()) {
+                    if (current_output_sample >= selected_samples.size()) {
+                        break;
+                    }
+                    genotype_columns_to_skip =
+                            selected_samples[current_output_sample] -
+                            current_genotype_field_index;
+                    if (genotype_columns_to_skip > 0) {
+                        if (!skip_genotype_columns()) {
+                            return VCF_parsing_event::need_more_data;
+                        }
+                        if (state == end_of_data_line) {
+                            break;
+                        }
+                    }
+                }
+            } else if (++current_genotype_value_index >=
+                    format_plan->keys.size()) {
+                gt_row_output = no_gt_row;
+                return parsing_error("Too many genotype info fields");
+            }
+        }
+
+        return end_gt_row();
+    }
+
+    VCF_parsing_event end_gt_row()
+    {
+        // The samples that follow the last GT value have none.
+        if (gt_row_output == gt_sparse_row) {
+            add_missing_sparse_gts(get_number_of_output_samples());
+        }
+
+        gt_row_output = no_gt_row;
+        return VCF_parsing_event::ok;
+    }
+
+    // Skips the genotype columns that consist of nothing but a
+    // homozygous reference diploid GT value, two columns at a time,
+    // without tokenizing them. Only applies when GT is the sole key
+    // and all samples are output. Used by the outputs that ignore
+    // such genotypes.
+    void skip_hom_ref_columns()
+    {
+        if (format_plan->keys.size() != 1 || format_plan->gt != 1 ||
+                !selected_samples.empty()) {
+            return;
+        }
+
+        static const char unphased[] = "0/0\t0/0\t";
+        static const char phased[] = "0|0\t0|0\t";
+
+        const char* ptr;
+        // The columns that follow must exist.
+        while (current_genotype_field_index + 2 < number_of_sample_ids &&
+                (ptr = tokenizer.peek(8)) != nullptr &&
+                (memcmp(ptr, unphased, 8) == 0 ||
+                        memcmp(ptr, phased, 8) == 0)) {
+            tokenizer.skip_token(ptr + 7);
+            current_genotype_field_index += 2;
+            if (gt_row_output == gt_sparse_row) {
+                add_missing_sparse_gts(current_output_sample);
+                next_sparse_sample = current_output_sample + 2;
+            }
+            current_output_sample += 2;
+        }
+    }
+
+    // Checks if the four bytes at 'ptr' are a three-byte GT token
+    // with a separator in the middle followed by a terminator.
+    bool is_short_gt_token(const char* ptr) const
+    {
+        const auto& terminators = tokenizer.newline_or_tab_or_colon;
+
+        return (ptr[1] == '/' || ptr[1] == '|') &&
+                terminators[(unsigned char) ptr[3]] &&
+                !terminators[(unsigned char) ptr[0]] &&
+                !terminators[(unsigned char) ptr[2]];
+    }
+
+    // Decodes a GT value of 'Ploidy' single-character alleles, such as
+    // '0/1' or './.', which is 2 * Ploidy - 1 characters long. Returns
+    // false if the value does not match this pattern or if an allele
+    // index is out of range, in which case the generic decoder must be
+    // used.
+    template <unsigned Ploidy>
+    bool decode_short_gt(const char* ptr, int* alleles, bool* phased) const
+    {
+        const int max_allele = alleles_parsed ? (int) number_of_alts : 9;
+
+        *phased = false;
+
+        for (unsigned i = 0; i < Ploidy; ++i) {
+            if (i > 0) {
+                const char separator = *ptr++;
+                if (separator == '|') {
+                    *phased = true;
+                } else if (separator == '/') {
+                    *phased = false;
+                } else {
+                    return false;
+                }
+            }
+            const int allele =
+                    tokenizer.gt_allele_chars[(unsigned char) *ptr++];
+            if (allele == VCF_tokenizer::not_an_allele ||
+                    allele > max_allele) {
+                return false;
+            }
+            alleles[i] = allele;
+        }
+
+        return true;
+    }
+
+    // Decodes a GT value into at most 'max_ploidy' allele indices
+    // (VCF_gt_missing for '.'). Returns the total number of alleles
+    // in 'ploidy', which can exceed 'max_ploidy'.
+    const char* decode_gt(const char* ptr, size_t len, int* alleles,
+            unsigned max_ploidy, unsigned* ploidy, bool* phased) const
+    {
+        switch (len) {
+        case 1:
+            if (max_ploidy >= 1 && decode_short_gt<1>(ptr, alleles, phased)) {
+                *ploidy = 1;
+                return nullptr;
+            }
+            break;
+        case 3:
+            if (max_ploidy >= 2 && decode_short_gt<2>(ptr, alleles, phased)) {
+                *ploidy = 2;
+                return nullptr;
+            }
+        }
+
+        if (len == 0) {
+            return "Empty GT value";
+        }
+
+        const char* const end = ptr + len;
+        unsigned number_of_alleles = 0;
+
+        *phased = false;
+
+        for (;;) {
+            int allele;
+
+            if (*ptr == '.') {
+                allele = VCF_gt_missing;
+                ++ptr;
+            } else {
+                unsigned digit = (unsigned) *ptr - '0';
+                if (digit > 9) {
+                    return "Invalid character in GT value";
+                }
+                unsigned index = digit;
+                while (++ptr < end && (digit = (unsigned) *ptr - '0') <= 9) {
+                    if (index > (INT_MAX - digit) / 10) {
+                        return "Integer overflow in allele index";
+                    }
+                    index = index * 10 + digit;
+                }
+                if (alleles_parsed && index > number_of_alts) {
+                    return "Allele index exceeds the number of alleles";
+                }
+                allele = (int) index;
+            }
+
+            if (number_of_alleles < max_ploidy) {
+                alleles[number_of_alleles] = allele;
+            }
+            ++number_of_alleles;
+
+            if (ptr == end) {
+                break;
+            }
+            switch (*ptr) {
+            case '/':
+                *phased = false;
+                break;
+            case '|':
+                *phased = true;
+                break;
+            default:
+                return "Invalid character in GT value";
+            }
+            if (++ptr == end) {
+                return "Invalid character in GT value";
+            }
+        }
+
+        *ploidy = number_of_alleles;
+        return nullptr;
+    }
+
+    // Passes a GT value to the output selected by 'parse_gt_row()'.
+    const char* store_gt_row_value(const char* ptr, size_t len)
+    {
+        switch (gt_row_output) {
+        case gt_matrix_row:
+            return store_gt_matrix_value(ptr, len);
+        case gt_packed_row:
+            return store_packed_gt_value(ptr, len);
+        case gt_allele_counts:
+            return count_gt_value(ptr, len);
+        case gt_sparse_row:
+            return store_sparse_gt_value(ptr, len);
+        case gt_predicate_row:
+            return evaluate_gt_value(ptr, len);
+        default /* dosage_float_row or dosage_fixed_row */:
+            return store_dosage_value(ptr, len);
+        }
+    }
+
+    // Lists the samples from 'next_sparse_sample' up to
+    // 'end_sample' as missing.
+    void add_missing_sparse_gts(unsigned end_sample)
+    {
+        for (; next_sparse_sample < end_sample; ++next_sparse_sample) {
+            gt_row_sparse->samples.push_back(next_sparse_sample);
+            gt_row_sparse->alleles.insert(gt_row_sparse->alleles.end(),
+                    gt_row_sparse->ploidy, VCF_gt_missing);
+            gt_row_sparse->phased.push_back(false);
+        }
+    }
+
+    // Lists the GT value of the current sample unless
+    // it is homozygous reference.
+    const char* store_sparse_gt_value(const char* ptr, size_t len)
+    {
+        const unsigned sample = current_output_sample;
+
+        add_missing_sparse_gts(sample);
+        next_sparse_sample = sample + 1;
+
+        // The most common values are checked on the raw bytes.
+        if ((len == 3 && ptr[0] == '0' && ptr[2] == '0' &&
+                    (ptr[1] == '/' || ptr[1] == '|')) ||
+                (len == 1 && ptr[0] == '0')) {
+            return nullptr;
+        }
+
+        int alleles[max_gt_row_ploidy];
+        unsigned ploidy;
+        bool phased;
+
+        const char* err_msg = decode_gt(
+                ptr, len, alleles, gt_row_sparse->ploidy, &ploidy, &phased);
+        if (err_msg != nullptr) {
+            return err_msg;
+        }
+        if (ploidy > gt_row_sparse->ploidy) {
+            return "Ploidy exceeds that of the sparse genotype row";
+        }
+
+        bool hom_ref = true;
+        for (unsigned i = 0; i < ploidy; ++i) {
+            if (alleles[i] > INT8_MAX) {
+                return "Allele index does not fit into the genotype row";
+            }
+            hom_ref = hom_ref && alleles[i] == 0;
+        }
+        if (hom_ref) {
+            return nullptr;
+        }
+
+        gt_row_sparse->samples.push_back(sample);
+        for (unsigned i = 0; i < gt_row_sparse->ploidy; ++i) {
+            gt_row_sparse->alleles.push_back(i < ploidy ?
+                            (int8_t) alleles[i] :
+                            VCF_gt_vector_end);
+        }
+        gt_row_sparse->phased.push_back(phased);
+
+        return nullptr;
+    }
+
+    // Counts the GT value of the current sample if it belongs to the
+    // class of the predicate. Stops parsing the row by resetting
+    // 'gt_row_output' once the result is known.
+    const char* evaluate_gt_value(const char* ptr, size_t len)
+    {
+        // Homozygous reference genotypes belong to no class.
+        if ((len == 3 && ptr[0] == '0' && ptr[2] == '0' &&
+                    (ptr[1] == '/' || ptr[1] == '|')) ||
+                (len == 1 && ptr[0] == '0')) {
+            stop_if_gt_predicate_unreachable(current_output_sample + 1);
+            return nullptr;
+        }
+
+        int alleles[max_gt_row_ploidy];
+        unsigned ploidy;
+        bool phased;
+
+        const char* err_msg = decode_gt(
+                ptr, len, alleles, max_gt_row_ploidy, &ploidy, &phased);
+        if (err_msg != nullptr) {
+            return err_msg;
+        }
+        if (ploidy > max_gt_row_ploidy) {
+            return "Ploidy exceeds the supported maximum";
+        }
+
+        bool missing = false, carrier = false, hom = true;
+        for (unsigned i = 0; i < ploidy; ++i) {
+            if (alleles[i] == VCF_gt_missing) {
+                missing = true;
+            } else {
+                carrier = carrier || alleles[i] != 0;
+                hom = hom && alleles[i] == alleles[0];
+            }
+        }
+
+        bool matches;
+        switch (gt_predicate.genotype_class) {
+        case VCF_gt_predicate::carrier:
+            matches = carrier;
+            break;
+        case VCF_gt_predicate::het:
+            matches = !missing && carrier && !hom;
+            break;
+        default /* VCF_gt_predicate::hom_alt */:
+            matches = !missing && carrier && hom;
+        }
+
+        if (matches && ++gt_predicate_count >= gt_predicate.min_samples) {
+            *gt_predicate_result = true;
+            gt_row_output = no_gt_row;
+            return nullptr;
+        }
+
+        stop_if_gt_predicate_unreachable(current_output_sample + 1);
+        return nullptr;
+    }
+
+    // Stops parsing the row if the samples starting from 'next_sample'
+    // are too few for the predicate to become true.
+    void stop_if_gt_predicate_unreachable(unsigned next_sample)
+    {
+        if (gt_predicate_count + get_number_of_output_samples() -
+                        next_sample <
+                gt_predicate.min_samples) {
+            gt_row_output = no_gt_row;
+        }
+    }
+
+    // Parses a decimal number without an exponent, like '0.123',
+    // into an integer mantissa and the number of digits after the
+    // point. The number ends at 'end' or at the first character
+    // that cannot belong to it, which is returned in 'number_end'.
+    // Returns false if the number has no digits or more than nine
+    // digits.
+    static bool parse_fixed_decimal(const char* ptr, const char* end,
+            uint32_t* mantissa, unsigned* fraction_digits,
+            const char** number_end)
+    {
+        uint32_t number = 0;
+        unsigned digits = 0;
+        unsigned digit;
+
+        for (; ptr < end && (digit = (unsigned) *ptr - '0') <= 9; ++ptr) {
+            number = number * 10 + digit;
+            ++digits;
+        }
+        const unsigned integer_digits = digits;
+        if (ptr < end && *ptr == '.') {
+            while (++ptr < end && (digit = (unsigned) *ptr - '0') <= 9) {
+                number = number * 10 + digit;
+                ++digits;
+            }
+        }
+
+        if (digits == 0 || digits > 9) {
+            return false;
+        }
+        *mantissa = number;
+        *fraction_digits = digits - integer_digits;
+        *number_end = ptr;
+        return true;
+    }
+
+    static const uint32_t* decimal_powers()
+    {
+        static const uint32_t powers[] = {1, 10, 100, 1000, 10000, 100000,
+                1000000, 10000000, 100000000, 1000000000};
+        return powers;
+    }
+
+    // Returns 'mantissa / Power' in units of 1 / VCF_dosage_unit
+    // rounded half up. The constant divisor lets the compiler
+    // replace the division with a multiplication.
+    template <uint32_t Power>
+    static uint64_t to_dosage_units(uint32_t mantissa)
+    {
+        return ((uint64_t) mantissa * VCF_dosage_unit + Power / 2) / Power;
+    }
+
+    // Converts a fixed-format dosage value to a multiple
+    // of 1 / VCF_dosage_unit rounding half up.
+    static bool fixed_decimal_to_units(
+            uint32_t mantissa, unsigned fraction_digits, uint16_t* dosage)
+    {
+        uint64_t units;
+
+        switch (fraction_digits) {
+        case 0:
+            units = (uint64_t) mantissa * VCF_dosage_unit;
+            break;
+        case 1:
+            units = to_dosage_units<10>(mantissa);
+            break;
+        case 2:
+            units = to_dosage_units<100>(mantissa);
+            break;
+        case 3:
+            units = to_dosage_units<1000>(mantissa);
+            break;
+        case 4:
+            units = to_dosage_units<10000>(mantissa);
+            break;
+        default:
+            const uint32_t power = decimal_powers()[fraction_digits];
+            units = ((uint64_t) mantissa * VCF_dosage_unit + power / 2) /
+                    power;
+        }
+
+        if (units >= VCF_missing_dosage) {
+            return false;
+        }
+        *dosage = (uint16_t) units;
+        return true;
+    }
+
+    // Converts a dosage value in any other format.
+    bool parse_dosage(const char* ptr, const char* end, size_t index) const
+    {
+        float value;
+        if (!VCF_float_parser::parse(ptr, end, &value)) {
+            return false;
+        }
+        if (gt_row_output == dosage_float_row) {
+            dosage_row_floats[index] = value;
+            return true;
+        }
+        if (!(value >= 0) ||
+                value >= (float) VCF_missing_dosage / VCF_dosage_unit) {
+            return false;
+        }
+        dosage_row_fixed[index] =
+                (uint16_t) (value * VCF_dosage_unit + 0.5f);
+        return true;
+    }
+
+    // Decodes the comma-separated values of the dosage key
+    // of the current sample into the dosage row.
+    const char* store_dosage_value(const char* ptr, size_t len)
+    {
+        const char* const end = ptr + len;
+
+        // A single missing value stands for all values.
+        if (is_missing_value(ptr, end)) {
+            return nullptr;
+        }
+
+        size_t index = (size_t) current_output_sample * dosage_row_width;
+        const size_t row_end = index + dosage_row_width;
+
+        for (;;) {
+            if (index == row_end) {
+                return "Unexpected number of dosage values";
+            }
+
+            uint32_t mantissa;
+            unsigned fraction_digits;
+            const char* value_end;
+
+            // Fixed-format values are converted in the same
+            // pass that finds the end of the value.
+            if (!parse_fixed_decimal(ptr, end, &mantissa, &fraction_digits,
+                        &value_end) ||
+                    (value_end < end && *value_end != ',') ||
+                    !(gt_row_output == dosage_float_row ?
+                                    VCF_float_parser::convert_exactly(
+                                            mantissa, -(int) fraction_digits,
+                                            dosage_row_floats + index) :
+                                    fixed_decimal_to_units(mantissa,
+                                            fraction_digits,
+                                            dosage_row_fixed + index))) {
+                value_end = (const char*) memchr(ptr, ',', end - ptr);
+                if (value_end == nullptr) {
+                    value_end = end;
+                }
+                if (!is_missing_value(ptr, value_end) &&
+                        !parse_dosage(ptr, value_end, index)) {
+                    return "Invalid dosage value";
+                }
+            }
+
+            ++index;
+
+            if (value_end == end) {
+                return index == row_end ?
+                        nullptr :
+                        "Unexpected number of dosage values";
+            }
+            ptr = value_end + 1;
+        }
+    }
+
+    // Maximum ploidy that 'parse_gt_row()' can decode.
+    static constexpr unsigned max_gt_row_ploidy = 64;
+
+    // Decodes a GT value into the row of a genotype matrix.
+    const char* store_gt_matrix_value(const char* ptr, size_t len)
+    {
+        int alleles[max_gt_row_ploidy];
+        unsigned ploidy;
+        bool phased;
+
+        const char* err_msg =
+                decode_gt(ptr, len, alleles, gt_row_ploidy, &ploidy, &phased);
+        if (err_msg != nullptr) {
+            return err_msg;
+        }
+        if (ploidy > gt_row_ploidy) {
+            return "Ploidy exceeds that of the genotype matrix";
+        }
+
+        const unsigned sample = current_output_sample;
+        int8_t* const row = gt_row_alleles + (size_t) sample * gt_row_ploidy;
+
+        for (unsigned i = 0; i < ploidy; ++i) {
+            if (alleles[i] > INT8_MAX) {
+                return "Allele index does not fit into the genotype matrix";
+            }
+            row[i] = (int8_t) alleles[i];
+        }
+        while (ploidy < gt_row_ploidy) {
+            row[ploidy++] = VCF_gt_vector_end;
+        }
+
+        if (phased) {
+            gt_row_phasing[sample / 8] |= (uint8_t) (1U << (sample % 8));
+        }
+
+        return nullptr;
+    }
+
+    // Sets the 2-bit code of a sample in a packed genotype row.
+    static void set_packed_gt(uint8_t* packed, unsigned sample, unsigned code)
+    {
+        uint8_t& byte = packed[sample / 4];
+        const unsigned shift = (sample % 4) * 2;
+        byte = (uint8_t) ((byte & ~(3U << shift)) | (code << shift));
+    }
+
+    // Decodes a GT value into a 2-bit code.
+    const char* store_packed_gt_value(const char* ptr, size_t len)
+    {
+        int alleles[2];
+        unsigned ploidy;
+        bool phased;
+
+        const char* err_msg =
+                decode_gt(ptr, len, alleles, 2, &ploidy, &phased);
+        if (err_msg != nullptr) {
+            return err_msg;
+        }
+
+        unsigned code = VCF_packed_gt_missing;
+
+        // Haploid genotypes are treated as homozygous;
+        // polyploid genotypes cannot be represented.
+        if (ploidy == 1) {
+            alleles[1] = alleles[0];
+        }
+        if (ploidy <= 2 && alleles[0] != VCF_gt_missing &&
+                alleles[1] != VCF_gt_missing) {
+            if ((alleles[0] > 1 || alleles[1] > 1) &&
+                    multiallelic_policy !=
+                            VCF_multiallelic_policy::collapse_alts) {
+                if (multiallelic_policy == VCF_multiallelic_policy::error) {
+                    return "Genotype refers to a second ALT allele";
+                }
+            } else {
+                const unsigned alts =
+                        (alleles[0] != 0 ? 1U : 0U) + (alleles[1] != 0);
+                code = alts == 0 ?
+                        VCF_packed_gt_hom_ref :
+                        alts == 1 ? VCF_packed_gt_het : VCF_packed_gt_hom_alt;
+            }
+        }
+
+        set_packed_gt(gt_row_packed, current_output_sample, code);
+        return nullptr;
+    }
+
+    // Adds the alleles of a GT value to the allele counts.
+    const char* count_gt_value(const char* ptr, size_t len)
+    {
+        int alleles[max_gt_row_ploidy];
+        unsigned ploidy;
+        bool phased;
+
+        const char* err_msg = decode_gt(
+                ptr, len, alleles, max_gt_row_ploidy, &ploidy, &phased);
+        if (err_msg != nullptr) {
+            return err_msg;
+        }
+        if (ploidy > max_gt_row_ploidy) {
+            return "Ploidy exceeds the supported maximum";
+        }
+
+        VCF_allele_counts* const counts = gt_row_counts;
+        std::vector<unsigned>& allele_counts = counts->allele_counts;
+
+        bool missing = false, hom_ref = true, hom = true;
+
+        for (unsigned i = 0; i < ploidy; ++i) {
+            const int allele = alleles[i];
+            if (allele == VCF_gt_missing) {
+                missing = true;
+                continue;
+            }
+            if ((size_t) allele >= allele_counts.size()) {
+                allele_counts.resize((size_t) allele + 1, 0);
+            }
+            ++allele_counts[(size_t) allele];
+            ++counts->number_of_called_alleles;
+            hom_ref = hom_ref && allele == 0;
+            hom = hom && allele == alleles[0];
+        }
+
+        if (!missing) {
+            --counts->missing;
+            if (hom_ref) {
+                ++counts->hom_ref;
+            } else if (hom) {
+                ++counts->hom_alt;
+            } else {
+                ++counts->het;
+            }
+        }
+
+        return nullptr;
+    }
+
+    const char* parse_gt(const char* ptr, size_t len)
+    {
+        if (len == 3) {
+            int alleles[2];
+            if (decode_short_gt<2>(ptr, alleles, &phased_gt)) {
+                gt.resize(2);
+                gt[0] = alleles[0];
+                gt[1] = alleles[1];
+                sample_ploidy = 2;
+                return nullptr;
+            }
+        }
+
+        gt.clear();
 
         if (len == 0) {
             return "Empty GT value";
         }
 
-        const char* ptr = token.data();
+        const char* const end = ptr + len;
         unsigned digit, allele;
 
-        for (;; ++ptr, --len) {
+        for (;;) {
             if (*ptr == '.') {
                 gt.push_back(-1);
                 ++ptr;
-                --len;
             } else {
                 if ((allele = (unsigned) *ptr - '0') > 9) {
                     break;
                 }
 
-                while (--len > 0 && (digit = (unsigned) *++ptr - '0') <= 9) {
+                while (++ptr < end && (digit = (unsigned) *ptr - '0') <= 9) {
                     if (allele > (UINT_MAX / 10) ||
                             (allele == (UINT_MAX / 10) &&
                                     digit > UINT_MAX % 10)) {
@@ -886,18 +3321,23 @@ protected:
                     return "Allele index exceeds the number of alleles";
                 }
             }
-            if (len == 0) {
+            if (ptr == end) {
+                sample_ploidy = gt.size();
                 return nullptr;
             }
             switch (*ptr) {
             case '/':
                 phased_gt = false;
-                continue;
+                break;
             case '|':
                 phased_gt = true;
-                continue;
+                break;
+            default:
+                return "Invalid character in GT value";
+            }
+            if (++ptr == end) {
+                break;
             }
-            break;
         }
         return "Invalid character in GT value";
     }
@@ -0,0 +1,251 @@
+// This header contains implementation details.
+#ifndef VCF_PARALLEL__HH
+#    error this file is not meant to be included directly
+#endif
+
+class VCF_shard_planner_impl
+{
+protected:
+    explicit VCF_shard_planner_impl(const VCF_input& i) : input(i) {}
+
+    static constexpr size_t read_block_size = 64 * 1024;
+
+    // Finds the offset of the first byte after the newline that
+    // follows 'offset'.  Returns the input size if there is no
+    // newline past 'offset'.
+    bool find_next_line(uint64_t offset, uint64_t* next_line_offset)
+    {
+        const uint64_t input_size = input.get_size();
+
+        block.resize(read_block_size);
+
+        while (offset < input_size) {
+            const ssize_t bytes_read =
+                    input.read_at(offset, block.data(), block.size());
+            if (bytes_read <= 0) {
+                error_message = bytes_read < 0 ? input.get_error() :
+                                                 "Unexpected end of input";
+                return false;
+            }
+            const char* newline =
+                    (const char*) memchr(block.data(), '\n', bytes_read);
+            if (newline != nullptr) {
+                *next_line_offset = offset + (newline - block.data()) + 1;
+                return true;
+            }
+            offset += (uint64_t) bytes_read;
+        }
+
+        *next_line_offset = input_size;
+        return true;
+    }
+
+    // Returns the first byte of the line that contains 'offset'
+    // or the line that begins right after it.
+    bool align_to_line(uint64_t offset, uint64_t* line_offset)
+    {
+        if (offset <= data_offset) {
+            *line_offset = data_offset;
+            return true;
+        }
+
+        // The line begins at 'offset' if the preceding byte is
+        // a newline character.
+        return find_next_line(offset - 1, line_offset);
+    }
+
+    VCF_parsing_event parse_header_impl(VCF_header* header)
+    {
+        // Find the first line that does not start with a hash sign.
+        const uint64_t input_size = input.get_size();
+
+        data_offset = 0;
+
+        while (data_offset < input_size) {
+            char first_char;
+            const ssize_t bytes_read =
+                    input.read_at(data_offset, &first_char, 1);
+            if (bytes_read <= 0) {
+                error_message = bytes_read < 0 ? input.get_error() :
+                                                 "Unexpected end of input";
+                return VCF_parsing_event::error;
+            }
+            if (first_char != '#') {
+                break;
+            }
+            if (!find_next_line(data_offset, &data_offset)) {
+                return VCF_parsing_event::error;
+            }
+        }
+
+        VCF_scanner scanner;
+        VCF_range_feeder feeder(
+                input, VCF_byte_range{0, data_offset}, read_block_size);
+
+        VCF_parsing_event pe = scanner.parse_header(header);
+        while (pe == VCF_parsing_event::need_more_data) {
+            pe = feeder.read_and_feed(scanner);
+        }
+        if (pe == VCF_parsing_event::error) {
+            error_message = feeder.get_error().empty() ? scanner.get_error() :
+                                                         feeder.get_error();
+        }
+        return pe;
+    }
+
+    bool plan_shards_impl(
+            unsigned number_of_shards, std::vector<VCF_byte_range>* shards)
+    {
+        shards->clear();
+
+        if (number_of_shards == 0) {
+            error_message = "The number of shards must be positive";
+            return false;
+        }
+
+        const uint64_t input_size = input.get_size();
+        const uint64_t data_size = input_size - data_offset;
+
+        uint64_t shard_begin = data_offset;
+
+        for (unsigned i = 1; i < number_of_shards; ++i) {
+            uint64_t shard_end;
+            if (!align_to_line(data_offset + data_size / number_of_shards * i +
+                                data_size % number_of_shards * i /
+                                        number_of_shards,
+                        &shard_end)) {
+                return false;
+            }
+            // A line longer than the shard size may already
+            // have taken the place of this shard.
+            if (shard_end < shard_begin) {
+                shard_end = shard_begin;
+            }
+            shards->push_back(VCF_byte_range{shard_begin, shard_end});
+            shard_begin = shard_end;
+        }
+
+        shards->push_back(VCF_byte_range{shard_begin, input_size});
+
+        return true;
+    }
+
+    // Reads the CHROM field of the line that starts at 'line_offset'.
+    bool read_chrom(uint64_t line_offset, std::string* chrom)
+    {
+        chrom->clear();
+
+        block.resize(256);
+
+        for (;;) {
+            const ssize_t bytes_read =
+                    input.read_at(line_offset, block.data(), block.size());
+            if (bytes_read < 0) {
+                error_message = input.get_error();
+                return false;
+            }
+            if (bytes_read == 0) {
+                return true;
+            }
+            const char* const end = block.data() + bytes_read;
+            const char* ptr = block.data();
+            while (ptr < end && *ptr != '\t' && *ptr != '\n') {
+                ++ptr;
+            }
+            chrom->append(block.data(), ptr - block.data());
+            if (ptr < end) {
+                return true;
+            }
+            line_offset += (uint64_t) bytes_read;
+        }
+    }
+
+    // Finds the lines where CHROM changes between the line that
+    // starts at 'lo' and the line that starts at 'hi'.  The lines
+    // that share the same contig are assumed to be adjacent, which
+    // allows for a binary search.
+    bool find_contig_boundaries(uint64_t lo, const std::string& lo_chrom,
+            uint64_t hi, const std::string& hi_chrom,
+            std::vector<VCF_contig_range>* contig_ranges)
+    {
+        uint64_t next_line;
+        if (!find_next_line(lo, &next_line)) {
+            return false;
+        }
+        if (next_line >= hi) {
+            if (hi < input.get_size()) {
+                contig_ranges->back().range.end = hi;
+                contig_ranges->push_back(
+                        VCF_contig_range{hi_chrom, VCF_byte_range{hi, hi}});
+            }
+            return true;
+        }
+
+        uint64_t middle;
+        if (!align_to_line(lo + (hi - lo) / 2, &middle)) {
+            return false;
+        }
+        if (middle <= lo || middle >= hi) {
+            middle = next_line;
+        }
+
+        std::string middle_chrom;
+        if (!read_chrom(middle, &middle_chrom)) {
+            return false;
+        }
+
+        if (middle_chrom != lo_chrom &&
+                !find_contig_boundaries(lo, lo_chrom, middle, middle_chrom,
+                        contig_ranges)) {
+            return false;
+        }
+
+        return middle_chrom == hi_chrom ||
+                find_contig_boundaries(
+                        middle, middle_chrom, hi, hi_chrom, contig_ranges);
+    }
+
+    bool plan_contigs_impl(std::vector<VCF_contig_range>* contig_ranges)
+    {
+        contig_ranges->clear();
+
+        const uint64_t input_size = input.get_size();
+
+        if (data_offset >= input_size) {
+            return true;
+        }
+
+        std::string first_chrom;
+        if (!read_chrom(data_offset, &first_chrom)) {
+            return false;
+        }
+
+        contig_ranges->push_back(VCF_contig_range{
+                first_chrom, VCF_byte_range{data_offset, data_offset}});
+
+        // The end of input is represented by a name that
+        // cannot be a valid CHROM value.
+        if (!find_contig_boundaries(data_offset, first_chrom, input_size,
+                    std::string(1, '\t'), contig_ranges)) {
+            return false;
+        }
+
+        contig_ranges->back().range.end = input_size;
+
+        std::set<std::string> seen_contigs;
+        for (const auto& contig_range : *contig_ranges) {
+            if (!seen_contigs.insert(contig_range.contig).second) {
+                error_message = "Data lines of contig '" +
+                        contig_range.contig + "' are not adjacent";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    const VCF_input& input;
+    uint64_t data_offset = 0;
+    std::vector<char> block;
+    std::string error_message;
+};
@@ -0,0 +1,40 @@
+// This header contains implementation details.
+#ifndef VCF_SCANNER__HH
+#    error this file is not meant to be included directly
+#endif
+
+// Keeps the strings removed from string lists, so that their buffers
+// can be reused when the lists grow again. Once the lists have been
+// filled with the longest values they receive, no memory is allocated.
+class VCF_string_pool
+{
+public:
+    // Replaces the element of 'list' at 'index' or appends a new
+    // element if 'index' is equal to the size of the list.
+    void set(std::vector<std::string>* list, size_t index, const char* value,
+            size_t value_len)
+    {
+        if (index == list->size()) {
+            if (spare_strings.empty()) {
+                list->emplace_back();
+            } else {
+                list->push_back(std::move(spare_strings.back()));
+                spare_strings.pop_back();
+            }
+        }
+        (*list)[index].assign(value, value_len);
+    }
+
+    // Removes the elements of 'list' that follow the first 'size'
+    // elements and keeps their buffers.
+    void truncate(std::vector<std::string>* list, size_t size)
+    {
+        while (list->size() > size) {
+            spare_strings.push_back(std::move(list->back()));
+            list->pop_back();
+        }
+    }
+
+private:
+    std::vector<std::string> spare_strings;
+};
@@ -4,8 +4,11 @@
 #include <string>
 #include <iostream>
 #include <climits>
+#include <cassert>
 #include <cstring>
+#include <cstdint>
 #include <array>
+#include <vector>
 
 #include "string_view.hh"
 
@@ -86,6 +89,38 @@ public:
     }
 
 private:
+    // Helpers for processing eight bytes at a time.
+
+    static uint64_t load_word(const char* ptr) noexcept
+    {
+        uint64_t word;
+        memcpy(&word, ptr, sizeof(word));
+        return word;
+    }
+
+    static constexpr uint64_t every_byte(uint8_t byte) noexcept
+    {
+        return 0x0101010101010101ULL * byte;
+    }
+
+    // Returns a word that has the high bit set in each byte where
+    // 'word' contains 'c'. The other bits are zero.
+    static uint64_t match_bytes(uint64_t word, char c) noexcept
+    {
+        const uint64_t low_bits = every_byte(0x7F);
+        const uint64_t zero_if_match = word ^ every_byte((uint8_t) c);
+
+        // Carries never cross byte boundaries.
+        return ~(((zero_if_match & low_bits) + low_bits) | zero_if_match |
+                low_bits);
+    }
+
+    // Returns the number of bytes found by match_bytes().
+    static unsigned count_matches(uint64_t matches) noexcept
+    {
+        return (unsigned) (((matches >> 7) * every_byte(1)) >> 56);
+    }
+
     void set_terminator(int term) noexcept
     {
         terminator = term;
@@ -206,6 +241,77 @@ public:
         return true;
     }
 
+    // Same as prepare_token_or_accumulate(), but instead of copying the
+    // token, returns a pointer to its first character and its length.
+    // When the token is entirely within the current buffer, the returned
+    // pointer points into that buffer. Otherwise, it points to the
+    // accumulated data. In both cases, the token remains valid until the
+    // next call to a method of this class.
+    bool prepare_token_view_or_accumulate(const char* const end_of_token,
+            const char** token_begin, size_t* token_len) noexcept
+    {
+        if (end_of_token == nullptr) {
+            if (!eof_reached) {
+                if (accumulating) {
+                    accumulator.append(current_ptr, remaining_size);
+                } else {
+                    accumulating = true;
+                    accumulator.assign(current_ptr, remaining_size);
+                }
+
+                return false;
+            }
+
+            set_terminator(eof);
+            if (!accumulating) {
+                *token_begin = current_ptr;
+                *token_len = 0;
+            } else {
+                accumulating = false;
+                *token_begin = accumulator.data();
+                *token_len = accumulator.length();
+            }
+            return true;
+        }
+
+        set_terminator_and_inc_line_num_if_newline(
+                (unsigned char) *end_of_token);
+
+        size_t token_len_without_cr = end_of_token - current_ptr;
+
+        if (!accumulating) {
+            if (*end_of_token == '\n' && token_len_without_cr > 0 &&
+                    end_of_token[-1] == '\r') {
+                --token_len_without_cr;
+            }
+            *token_begin = current_ptr;
+            *token_len = token_len_without_cr;
+        } else {
+            accumulating = false;
+            accumulator.append(current_ptr, token_len_without_cr);
+            if (*end_of_token == '\n' && accumulator.length() > 0 &&
+                    accumulator.back() == '\r') {
+                accumulator.pop_back();
+            }
+            *token_begin = accumulator.data();
+            *token_len = accumulator.length();
+        }
+
+        advance_by(end_of_token - current_ptr + 1);
+
+        return true;
+    }
+
+    // Returns the current position in the buffer if at least 'size'
+    // bytes remain there and no token is being accumulated; otherwise,
+    // returns nullptr. Used to look ahead for short tokens that can be
+    // recognized without searching for their terminator.
+    const char* peek(size_t size) const noexcept
+    {
+        return !accumulating && remaining_size >= size ? current_ptr :
+                                                         nullptr;
+    }
+
     bool skip_token(const char* const end_of_token) noexcept
     {
         accumulating = false;
@@ -230,6 +336,119 @@ public:
         return true;
     }
 
+    // Skips '*number_of_tabs' tab-terminated tokens without looking at
+    // their contents. Stops early after a newline, which becomes the
+    // terminator. Returns false if more data is needed, in which case
+    // '*number_of_tabs' is decreased by the number of tokens skipped
+    // so far.
+    bool skip_tabs(unsigned* number_of_tabs) noexcept
+    {
+        assert(*number_of_tabs > 0);
+
+        accumulating = false;
+
+        const char* ptr = current_ptr;
+        const char* const end = ptr + remaining_size;
+        unsigned tabs_to_skip = *number_of_tabs;
+
+        // Count tabs eight bytes at a time until the word that
+        // contains the last tab to skip or a newline is found.
+        while (end - ptr >= 8) {
+            const uint64_t word = load_word(ptr);
+
+            if (match_bytes(word, '\n') != 0) {
+                break;
+            }
+            const unsigned tab_count = count_matches(match_bytes(word, '\t'));
+            if (tab_count >= tabs_to_skip) {
+                break;
+            }
+            tabs_to_skip -= tab_count;
+            ptr += 8;
+        }
+
+        for (; ptr < end; ++ptr) {
+            if (*ptr == '\t') {
+                if (--tabs_to_skip == 0) {
+                    break;
+                }
+            } else if (*ptr == '\n') {
+                break;
+            }
+        }
+
+        *number_of_tabs = tabs_to_skip;
+
+        if (ptr == end) {
+            advance_by(remaining_size);
+            if (!eof_reached) {
+                return false;
+            }
+            set_terminator(eof);
+            return true;
+        }
+
+        set_terminator_and_inc_line_num_if_newline((unsigned char) *ptr);
+        advance_by(ptr - current_ptr + 1);
+        return true;
+    }
+
+    // Returns a pointer to the '*number_of_tabs'-th tab in the buffer
+    // or to the newline that precedes it. If neither is found, returns
+    // nullptr and decreases '*number_of_tabs' by the number of tabs
+    // in the buffer.
+    const char* find_nth_tab_or_newline(unsigned* number_of_tabs) const
+            noexcept
+    {
+        const char* const newline = find_newline();
+        const char* const end =
+                newline != nullptr ? newline : current_ptr + remaining_size;
+
+        const char* ptr = current_ptr;
+        unsigned tabs_to_find = *number_of_tabs;
+
+        while ((ptr = (const char*) memchr(ptr, '\t', end - ptr)) != nullptr) {
+            if (--tabs_to_find == 0) {
+                return ptr;
+            }
+            ++ptr;
+        }
+
+        if (newline == nullptr) {
+            *number_of_tabs = tabs_to_find;
+        }
+        return newline;
+    }
+
+    // Appends the offsets of all tabs within the 'size' bytes
+    // at 'ptr' to 'offsets'.
+    static void find_tabs(
+            const char* ptr, size_t size, std::vector<size_t>* offsets)
+    {
+        const char* const begin = ptr;
+        const char* const end = ptr + size;
+
+        while (end - ptr >= 8) {
+            // Words without tabs are skipped at once.
+            if (match_bytes(load_word(ptr), '\t') != 0) {
+                for (const char* const word_end = ptr + 8; ptr < word_end;
+                        ++ptr) {
+                    if (*ptr == '\t') {
+                        offsets->push_back(ptr - begin);
+                    }
+                }
+            } else {
+                ptr += 8;
+            }
+        }
+
+        for (; ptr < end; ++ptr) {
+            if (*ptr == '\t') {
+                offsets->push_back(ptr - begin);
+            }
+        }
+    }
+
     const VCF_string_view& get_token() const noexcept
     {
         return token;
@@ -349,12 +568,24 @@ public:
         newline_or_tab_or_colon[(unsigned char) '\t'] = true;
         newline_or_tab_or_colon[(unsigned char) ':'] = true;
 
+        newline_tab_semicolon_equals.fill(false);
+        newline_tab_semicolon_equals[(unsigned char) '\n'] = true;
+        newline_tab_semicolon_equals[(unsigned char) '\t'] = true;
+        newline_tab_semicolon_equals[(unsigned char) ';'] = true;
+        newline_tab_semicolon_equals[(unsigned char) '='] = true;
+
         newline_tab_colon_slash_bar.fill(false);
         newline_tab_colon_slash_bar[(unsigned char) '\n'] = true;
         newline_tab_colon_slash_bar[(unsigned char) '\t'] = true;
         newline_tab_colon_slash_bar[(unsigned char) ':'] = true;
         newline_tab_colon_slash_bar[(unsigned char) '/'] = true;
         newline_tab_colon_slash_bar[(unsigned char) '|'] = true;
+
+        gt_allele_chars.fill(not_an_allele);
+        gt_allele_chars[(unsigned char) '.'] = -1;
+        for (int digit = 0; digit <= 9; ++digit) {
+            gt_allele_chars[(unsigned char) ('0' + digit)] = (int8_t) digit;
+        }
     }
 
 private:
@@ -381,8 +612,15 @@ public:
     std::array<bool, 256> newline_or_tab_or_semicolon;
     // For extracting ALT
     std::array<bool, 256> newline_or_tab_or_comma;
+    // For extracting INFO keys
+    std::array<bool, 256> newline_tab_semicolon_equals;
     // For extracting FORMAT or GENOTYPE
     std::array<bool, 256> newline_or_tab_or_colon;
     // For extracting the GT values
     std::array<bool, 256> newline_tab_colon_slash_bar;
+
+    // Values of single-character GT alleles: allele indices
+    // for digits, -1 for '.', and 'not_an_allele' otherwise.
+    enum { not_an_allele = -128 };
+    std::array<int8_t, 256> gt_allele_chars;
 };
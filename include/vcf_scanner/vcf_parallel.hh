@@ -0,0 +1,602 @@
+/*
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ */
+
+#ifndef VCF_PARALLEL__HH
+#define VCF_PARALLEL__HH
+
+#include "vcf_scanner.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Interface to the thread pool that runs all parallel work of the library.
+//
+// Every parallel feature submits its tasks to an executor supplied by the
+// client code rather than starting threads of its own. This way, several
+// parallel features used at once share the same set of threads and do not
+// oversubscribe the available cores.
+//
+// The client code can implement this interface on top of an existing thread
+// pool of the application or use the VCF_thread_pool class below.
+class VCF_executor
+{
+public:
+    typedef std::function<void()> Task;
+
+    virtual ~VCF_executor() = default;
+
+    // Returns the number of tasks that the executor can run concurrently.
+    virtual unsigned get_concurrency() const = 0;
+
+    // Schedules the task for execution. Tasks must not throw exceptions.
+    virtual void submit(Task&& task) = 0;
+
+    // Runs one of the queued tasks in the calling thread. Returns false if
+    // there was nothing to run. Threads waiting for their subtasks call this
+    // method to help with the work instead of blocking. Executors that cannot
+    // run tasks outside of their own threads can keep the default
+    // implementation.
+    virtual bool run_pending_task()
+    {
+        return false;
+    }
+
+    // Returns the number of NUMA nodes that the executor threads are
+    // distributed across.
+    virtual unsigned get_number_of_nodes() const
+    {
+        return 1;
+    }
+
+    // Schedules the task for execution by a thread running on the specified
+    // NUMA node. Memory that the task allocates and touches first is then
+    // local to that node. Idle threads of other nodes may still steal the
+    // task.
+    virtual void submit_to_node(unsigned node, Task&& task)
+    {
+        (void) node;
+        submit(std::move(task));
+    }
+
+    // Returns the NUMA node of the calling thread if it belongs to
+    // this executor, or zero otherwise.
+    virtual unsigned get_current_node() const
+    {
+        return 0;
+    }
+};
+
+#include "impl/numa.hh"
+
+// NUMA nodes of the machine and the CPUs that belong to each of them.
+//
+// Nodes that have no CPUs are omitted. The remaining nodes are numbered
+// consecutively starting from zero. On systems where the topology cannot
+// be determined, a single node is reported and its CPU list is empty.
+class VCF_numa_topology final : public VCF_numa_topology_impl
+{
+public:
+    // Detects the topology of the current machine.
+    VCF_numa_topology()
+    {
+        detect_impl();
+    }
+
+    // Creates a topology with the specified CPU lists, one per node.
+    explicit VCF_numa_topology(std::vector<std::vector<unsigned>> cpus)
+    {
+        node_cpus = std::move(cpus);
+        if (node_cpus.empty()) {
+            node_cpus.resize(1);
+        }
+    }
+
+    unsigned get_number_of_nodes() const
+    {
+        return get_number_of_nodes_impl();
+    }
+
+    const std::vector<unsigned>& get_node_cpus(unsigned node) const
+    {
+        return get_node_cpus_impl(node);
+    }
+};
+
+#include "impl/executor.hh"
+
+// Work-stealing thread pool.
+//
+// Each worker thread has its own task queue. A task submitted from within a
+// worker goes to that worker's queue, which keeps recursively split work on
+// the same core. Idle workers steal the oldest tasks from their peers.
+//
+// When constructed with a NUMA topology, the pool binds its workers to the
+// CPUs of their nodes and prefers robbing workers of the same node.
+// Scanners, buffers, and output objects created inside the tasks are then
+// allocated in the memory of the node that processes them.
+class VCF_thread_pool final : public VCF_thread_pool_impl
+{
+public:
+    // Starts the worker threads. If 'number_of_threads' is zero, one thread
+    // per hardware thread is started. The destructor waits for all queued
+    // tasks to finish.
+    explicit VCF_thread_pool(unsigned number_of_threads = 0) :
+        VCF_thread_pool_impl(number_of_threads)
+    {}
+
+    // Starts 'threads_per_node' workers on each node of the topology.
+    // If 'threads_per_node' is zero, the number of CPUs of the respective
+    // node is used.
+    explicit VCF_thread_pool(
+            const VCF_numa_topology& topology, unsigned threads_per_node = 0) :
+        VCF_thread_pool_impl(topology, threads_per_node)
+    {}
+
+    ~VCF_thread_pool()
+    {
+        stop_workers();
+    }
+
+    unsigned get_concurrency() const override
+    {
+        return (unsigned) threads.size();
+    }
+
+    void submit(Task&& task) override
+    {
+        submit_impl(std::move(task));
+    }
+
+    bool run_pending_task() override
+    {
+        return run_pending_task_impl();
+    }
+
+    unsigned get_number_of_nodes() const override
+    {
+        return (unsigned) node_workers.size();
+    }
+
+    void submit_to_node(unsigned node, Task&& task) override
+    {
+        submit_to_node_impl(node, std::move(task));
+    }
+
+    unsigned get_current_node() const override
+    {
+        return get_current_node_impl();
+    }
+};
+
+// A set of related tasks that can be waited for as a whole.
+//
+// Tasks are submitted to the executor that was passed to the constructor.
+// Any number of task groups can share the same executor, and tasks can
+// create nested task groups of their own.
+class VCF_task_group final : public VCF_task_group_impl
+{
+public:
+    explicit VCF_task_group(VCF_executor& executor) :
+        VCF_task_group_impl(executor)
+    {}
+
+    // Submits a task that belongs to this group.
+    void run(VCF_executor::Task&& task)
+    {
+        run_impl(std::move(task));
+    }
+
+    // Submits a task that belongs to this group for execution on
+    // the specified NUMA node. See 'VCF_executor::submit_to_node()'.
+    void run_on_node(unsigned node, VCF_executor::Task&& task)
+    {
+        run_on_node_impl(node, std::move(task));
+    }
+
+    // Waits until all tasks of this group are finished. While waiting,
+    // the calling thread executes pending tasks of the executor. The
+    // destructor also waits for the group tasks.
+    void wait()
+    {
+        wait_impl();
+    }
+};
+
+// Random access source of VCF data.
+//
+// The same input object is shared by all parsers that process different
+// parts of the file in parallel. Implementations must therefore allow
+// 'read_at()' to be called from several threads at once.
+class VCF_input
+{
+public:
+    virtual ~VCF_input() = default;
+
+    // Returns the size of the input in bytes.
+    virtual uint64_t get_size() const = 0;
+
+    // Reads up to 'size' bytes starting at 'offset' into 'buffer'. Returns
+    // the number of bytes read, zero if 'offset' is at or past the end of
+    // input, or a negative value in case of an error.
+    virtual ssize_t read_at(
+            uint64_t offset, char* buffer, size_t size) const = 0;
+
+    // Returns the description of the last error.
+    virtual std::string get_error() const = 0;
+};
+
+// A file read with 'pread()'.
+class VCF_file_input final : public VCF_input
+{
+public:
+    explicit VCF_file_input(const char* pathname)
+    {
+        fd = open(pathname, O_RDONLY);
+        if (fd < 0) {
+            set_error(pathname);
+            return;
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) < 0) {
+            set_error(pathname);
+            close(fd);
+            fd = -1;
+            return;
+        }
+        file_size = (uint64_t) file_stat.st_size;
+    }
+
+    VCF_file_input(const VCF_file_input&) = delete;
+    VCF_file_input& operator=(const VCF_file_input&) = delete;
+
+    ~VCF_file_input()
+    {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    // Returns false if the file could not be opened. Use
+    // 'get_error()' to find out why.
+    bool is_open() const
+    {
+        return fd >= 0;
+    }
+
+    uint64_t get_size() const override
+    {
+        return file_size;
+    }
+
+    ssize_t read_at(uint64_t offset, char* buffer, size_t size) const override
+    {
+        ssize_t bytes_read;
+        do {
+            bytes_read = pread(fd, buffer, size, (off_t) offset);
+        } while (bytes_read < 0 && errno == EINTR);
+        if (bytes_read < 0) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            error_message = strerror(errno);
+        }
+        return bytes_read;
+    }
+
+    std::string get_error() const override
+    {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        return error_message;
+    }
+
+private:
+    void set_error(const char* pathname)
+    {
+        error_message = pathname;
+        error_message += ": ";
+        error_message += strerror(errno);
+    }
+
+    int fd;
+    uint64_t file_size = 0;
+    mutable std::mutex error_mutex;
+    mutable std::string error_message;
+};
+
+// VCF data that is already in memory, for example, a memory-mapped file.
+class VCF_memory_input final : public VCF_input
+{
+public:
+    VCF_memory_input(const char* data, size_t size) :
+        input_data(data), input_size(size)
+    {}
+
+    uint64_t get_size() const override
+    {
+        return input_size;
+    }
+
+    ssize_t read_at(uint64_t offset, char* buffer, size_t size) const override
+    {
+        if (offset >= input_size) {
+            return 0;
+        }
+        if (size > input_size - offset) {
+            size = (size_t) (input_size - offset);
+        }
+        memcpy(buffer, input_data + offset, size);
+        return (ssize_t) size;
+    }
+
+    std::string get_error() const override
+    {
+        return std::string();
+    }
+
+private:
+    const char* const input_data;
+    const size_t input_size;
+};
+
+// A half-open range of bytes [begin, end) within a VCF_input.
+struct VCF_byte_range {
+    uint64_t begin;
+    uint64_t end;
+};
+
+#include "impl/range_feeder.hh"
+
+// Reads a range of bytes from a VCF_input one buffer at a time and feeds
+// the data to a parser. When the end of the range is reached, the parser
+// receives an empty buffer, which it treats as the end of file.
+class VCF_range_feeder final : public VCF_range_feeder_impl
+{
+public:
+    VCF_range_feeder(const VCF_input& input, const VCF_byte_range& range,
+            size_t buffer_size = 1024 * 1024) :
+        VCF_range_feeder_impl(input, range, buffer_size)
+    {}
+
+    // Reads the next buffer and passes it to 'scanner.feed()'. Returns the
+    // result of 'feed()' or 'error' if the input could not be read. In the
+    // latter case, 'get_error()' returns the description of the I/O error.
+    VCF_parsing_event read_and_feed(VCF_scanner& scanner)
+    {
+        return read_and_feed_impl(scanner);
+    }
+
+    // Returns true if the entire range has been read. The next call
+    // to 'read_and_feed()' will signal the end of file to the parser.
+    bool at_end_of_range() const
+    {
+        return current_offset >= range.end;
+    }
+
+    // Returns the description of the I/O error that occurred
+    // during the last call to 'read_and_feed()' or an empty string.
+    const std::string& get_error() const
+    {
+        return error_message;
+    }
+};
+
+// The range of data lines that belong to the same contig.
+struct VCF_contig_range {
+    std::string contig;
+    VCF_byte_range range;
+};
+
+#include "impl/shard_planner.hh"
+
+// Splits the data lines of a VCF file into ranges that can be parsed
+// independently, for example, by separate threads, processes, or cluster
+// nodes.
+//
+// Each range begins at the start of a line. The data lines can be split
+// either into shards balanced by their size in bytes or into per-contig
+// ranges. Only uncompressed input is supported.
+class VCF_shard_planner final : public VCF_shard_planner_impl
+{
+public:
+    explicit VCF_shard_planner(const VCF_input& input) :
+        VCF_shard_planner_impl(input)
+    {}
+
+    // Parses the VCF header and finds where the data lines begin.
+    // This method must be called before 'plan_shards()'. Returns either
+    // 'ok' or 'error'.
+    VCF_parsing_event parse_header(VCF_header* header)
+    {
+        return parse_header_impl(header);
+    }
+
+    // Returns the offset of the first data line.
+    uint64_t get_data_offset() const
+    {
+        return data_offset;
+    }
+
+    // Splits the data lines into 'number_of_shards' ranges. Some of the
+    // ranges may be empty if the data lines are few or very long. Returns
+    // false if the input could not be read.
+    bool plan_shards(
+            unsigned number_of_shards, std::vector<VCF_byte_range>* shards)
+    {
+        return plan_shards_impl(number_of_shards, shards);
+    }
+
+    // Finds the range of data lines of each contig present in the file.
+    // Contigs are returned in the order of their appearance in the file,
+    // so concatenating per-contig results in this order reproduces the
+    // order of the file. The size of each range estimates the amount
+    // of work needed to parse the contig.
+    //
+    // Data lines of each contig must be adjacent, as in any file sorted
+    // by position. The boundaries are found by a binary search, which
+    // reads only a small number of lines per contig. An error is returned
+    // if the data lines of a contig turn out to be interleaved with other
+    // contigs.
+    bool plan_contigs(std::vector<VCF_contig_range>* contig_ranges)
+    {
+        return plan_contigs_impl(contig_ranges);
+    }
+
+    // Returns the description of the last error.
+    const std::string& get_error() const
+    {
+        return error_message;
+    }
+};
+
+#include "impl/range_scheduler.hh"
+
+// Parses a set of byte ranges in parallel.
+//
+// Each range is processed by a separate task of the executor. The task
+// creates a VCF_scanner, starts it at the beginning of the range, and passes
+// it to the processor function, which parses the data lines in the same way
+// as in the single-threaded case, using the supplied VCF_range_feeder to get
+// more data. Results are usually stored by the processor in a vector indexed
+// by the job index.
+//
+// Ranges are dispatched largest first and spread across the NUMA nodes of
+// the executor.
+class VCF_range_scheduler final : public VCF_range_scheduler_impl
+{
+public:
+    typedef std::function<void(
+            size_t job_index, VCF_scanner& scanner, VCF_range_feeder& feeder)>
+            Processor;
+
+    explicit VCF_range_scheduler(
+            VCF_executor& executor, size_t buffer_size = 1024 * 1024) :
+        VCF_range_scheduler_impl(executor, buffer_size)
+    {}
+
+    // Adds a range of data lines to parse. The input and the header
+    // must outlive the 'run()' call. Returns the index of the job.
+    size_t add_job(const VCF_input& input, const VCF_header& header,
+            const VCF_byte_range& range)
+    {
+        jobs.push_back(Job{&input, &header, range, std::string()});
+        return jobs.size() - 1;
+    }
+
+    size_t get_number_of_jobs() const
+    {
+        return jobs.size();
+    }
+
+    // Processes all jobs and waits for their completion.
+    void run(const Processor& processor)
+    {
+        run_impl(processor);
+    }
+
+    // Returns the I/O error that prevented the job from
+    // starting or an empty string.
+    const std::string& get_job_error(size_t job_index) const
+    {
+        return jobs[job_index].error_message;
+    }
+};
+
+#include "impl/file_set.hh"
+
+// A VCF data set split into several files, for example, one file per
+// chromosome.
+//
+// All files must have the same file format version and the same list of
+// samples. The data lines of the files can be read either as a single
+// stream in the order in which the files were added or in parallel with
+// one job per file.
+class VCF_file_set final : public VCF_file_set_impl
+{
+public:
+    // Opens the file and parses its header. Returns false if the file
+    // cannot be read or parsed or if its header is incompatible with
+    // the header of the first file. Use 'get_error()' to find out why.
+    bool add_file(const char* pathname)
+    {
+        return add_file_impl(pathname);
+    }
+
+    size_t get_number_of_files() const
+    {
+        return files.size();
+    }
+
+    const std::string& get_pathname(size_t file_index) const
+    {
+        return files[file_index]->pathname;
+    }
+
+    // Returns the header of the specified file.
+    const VCF_header& get_header(size_t file_index = 0) const
+    {
+        return files[file_index]->header;
+    }
+
+    // Parses all files in parallel. The job index passed to the processor
+    // is the index of the file. Larger files are scheduled first, so that
+    // the largest file does not finish last while the other cores are idle.
+    //
+    // Returns false if one of the files could not be read.
+    bool scan_in_parallel(VCF_executor& executor,
+            const VCF_range_scheduler::Processor& processor,
+            size_t buffer_size = 1024 * 1024)
+    {
+        error_message.clear();
+        scan_in_parallel_impl(executor, processor, buffer_size);
+        return error_message.empty();
+    }
+
+    // Reads the data lines of all files one after another and feeds them
+    // to the parser as if they were a single file. The parser must be
+    // started with 'start_at_data_line(get_header())'.
+    VCF_parsing_event read_and_feed(VCF_scanner& scanner)
+    {
+        return read_and_feed_impl(scanner);
+    }
+
+    // Returns the description of the last error.
+    const std::string& get_error() const
+    {
+        return error_message;
+    }
+};
+
+#endif /* !defined(VCF_PARALLEL__HH) */
@@ -0,0 +1,284 @@
+/*
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ */
+
+#ifndef VCF_PLINK__HH
+#define VCF_PLINK__HH
+
+#include "vcf_scanner.hh"
+
+#include <cerrno>
+#include <cstdio>
+
+// Streaming converter of VCF data to the PLINK binary fileset:
+// a .bed file with 2-bit genotypes, a .bim file with variant
+// information, and a .fam file with sample IDs.
+//
+// The ALT allele is written as A1 and the REF allele as A2. Genotypes
+// that refer to the second or subsequent ALT allele are handled in
+// accordance with the VCF_multiallelic_policy passed to the constructor.
+// With the 'collapse_alts' policy, all ALT alleles of the variant are
+// listed in the A1 column separated by commas.
+class VCF_plink_writer final
+{
+public:
+    explicit VCF_plink_writer(VCF_multiallelic_policy policy =
+                                      VCF_multiallelic_policy::as_missing) :
+        multiallelic_policy(policy)
+    {}
+
+    VCF_plink_writer(const VCF_plink_writer&) = delete;
+    VCF_plink_writer& operator=(const VCF_plink_writer&) = delete;
+
+    ~VCF_plink_writer()
+    {
+        close();
+    }
+
+    // Creates the 'prefix.bed', 'prefix.bim', and 'prefix.fam' files,
+    // writes the sample IDs from the header to the .fam file, and starts
+    // the .bed file. Returns false in case of an I/O error.
+    bool open(const std::string& prefix, const VCF_header& header)
+    {
+        return open(prefix, header, std::vector<unsigned>());
+    }
+
+    // Same as above, but only the samples with the specified indices
+    // are written to the .fam file. Use this method with the value of
+    // 'VCF_scanner::get_selected_samples()' when converting a subset
+    // of samples; an empty vector stands for all samples.
+    bool open(const std::string& prefix, const VCF_header& header,
+            const std::vector<unsigned>& selected_samples)
+    {
+        close();
+
+        const std::vector<std::string>& sample_ids = header.get_sample_ids();
+
+        const size_t number_of_samples = selected_samples.empty() ?
+                sample_ids.size() :
+                selected_samples.size();
+
+        number_of_variants = 0;
+        output_samples = selected_samples;
+        packed_row.resize((number_of_samples + 3) / 4);
+
+        bed_pathname = prefix + ".bed";
+        bim_pathname = prefix + ".bim";
+
+        if (!open_file(&bed_file, bed_pathname) ||
+                !open_file(&bim_file, bim_pathname)) {
+            return false;
+        }
+
+        FILE* fam_file;
+        const std::string fam_pathname = prefix + ".fam";
+        if (!open_file(&fam_file, fam_pathname)) {
+            return false;
+        }
+        if (selected_samples.empty()) {
+            for (const auto& sample_id : sample_ids) {
+                write_fam_line(fam_file, sample_id);
+            }
+        } else {
+            for (unsigned index : selected_samples) {
+                write_fam_line(fam_file, sample_ids[index]);
+            }
+        }
+        if (fclose(fam_file) != 0) {
+            return io_error(fam_pathname);
+        }
+
+        // SNP-major mode.
+        static const unsigned char magic_number[] = {0x6C, 0x1B, 0x01};
+        if (fwrite(magic_number, sizeof(magic_number), 1, bed_file) != 1) {
+            return io_error(bed_pathname);
+        }
+
+        return true;
+    }
+
+    // Converts the data lines from the current one to the end of
+    // the input. The 'feeder' object must have a 'read_and_feed()'
+    // method that supplies the scanner with the next buffer like
+    // 'VCF_range_feeder' or 'VCF_file_set' do. Returns false if
+    // a data line cannot be parsed or in case of an I/O error.
+    // The samples selected in the scanner must be the ones that
+    // were passed to 'open()'.
+    template <typename Feeder>
+    bool convert(VCF_scanner& vcf_scanner, Feeder& feeder)
+    {
+        if (vcf_scanner.get_selected_samples() != output_samples) {
+            error_message = "The samples selected in the scanner differ "
+                            "from the samples of the .fam file";
+            return false;
+        }
+
+        while (!vcf_scanner.at_eof()) {
+            if (!parse(vcf_scanner, feeder,
+                        vcf_scanner.parse_loc(&chrom, &pos)) ||
+                    !parse(vcf_scanner, feeder, vcf_scanner.parse_ids(&ids)) ||
+                    !parse(vcf_scanner, feeder,
+                            vcf_scanner.parse_alleles(&ref, &alts)) ||
+                    !parse(vcf_scanner, feeder,
+                            vcf_scanner.parse_genotype_format()) ||
+                    !parse(vcf_scanner, feeder,
+                            vcf_scanner.parse_packed_gt_row(
+                                    packed_row.data(), multiallelic_policy)) ||
+                    !write_variant() ||
+                    !parse(vcf_scanner, feeder, vcf_scanner.clear_line())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Flushes and closes the files. Returns false in case of an I/O error.
+    bool close()
+    {
+        bool ok = true;
+        if (bed_file != nullptr) {
+            if (fclose(bed_file) != 0 && ok) {
+                ok = io_error(bed_pathname);
+            }
+            bed_file = nullptr;
+        }
+        if (bim_file != nullptr) {
+            if (fclose(bim_file) != 0 && ok) {
+                ok = io_error(bim_pathname);
+            }
+            bim_file = nullptr;
+        }
+        return ok;
+    }
+
+    // Returns the number of variants written so far.
+    size_t get_number_of_variants() const
+    {
+        return number_of_variants;
+    }
+
+    // Returns the description of the last error.
+    const std::string& get_error() const
+    {
+        return error_message;
+    }
+
+private:
+    template <typename Feeder>
+    bool parse(VCF_scanner& vcf_scanner, Feeder& feeder, VCF_parsing_event pe)
+    {
+        while (pe == VCF_parsing_event::need_more_data) {
+            pe = feeder.read_and_feed(vcf_scanner);
+        }
+        if (pe == VCF_parsing_event::error) {
+            error_message = "Line " +
+                    std::to_string(vcf_scanner.get_line_number()) + ": " +
+                    vcf_scanner.get_error();
+            return false;
+        }
+        return true;
+    }
+
+    bool write_variant()
+    {
+        fputs(chrom.c_str(), bim_file);
+        putc('\t', bim_file);
+        write_list(ids, ';', '.');
+        fprintf(bim_file, "\t0\t%u\t", pos);
+        if (multiallelic_policy == VCF_multiallelic_policy::collapse_alts) {
+            write_list(alts, ',', '0');
+        } else if (alts.empty()) {
+            putc('0', bim_file);
+        } else {
+            fputs(alts.front().c_str(), bim_file);
+        }
+        putc('\t', bim_file);
+        fputs(ref.c_str(), bim_file);
+        if (putc('\n', bim_file) == EOF) {
+            return io_error(bim_pathname);
+        }
+
+        if (!packed_row.empty() &&
+                fwrite(packed_row.data(), packed_row.size(), 1, bed_file) !=
+                        1) {
+            return io_error(bed_pathname);
+        }
+
+        ++number_of_variants;
+        return true;
+    }
+
+    // Writes the list or the missing value if the list is empty.
+    void write_list(const std::vector<std::string>& list, char separator,
+            char missing_value)
+    {
+        if (list.empty()) {
+            putc(missing_value, bim_file);
+            return;
+        }
+        fputs(list.front().c_str(), bim_file);
+        for (size_t i = 1; i < list.size(); ++i) {
+            putc(separator, bim_file);
+            fputs(list[i].c_str(), bim_file);
+        }
+    }
+
+    static void write_fam_line(FILE* fam_file, const std::string& sample_id)
+    {
+        fprintf(fam_file, "%s\t%s\t0\t0\t0\t-9\n", sample_id.c_str(),
+                sample_id.c_str());
+    }
+
+    bool open_file(FILE** file, const std::string& pathname)
+    {
+        *file = fopen(pathname.c_str(), "wb");
+        return *file != nullptr || io_error(pathname);
+    }
+
+    bool io_error(const std::string& pathname)
+    {
+        error_message = pathname + ": " + strerror(errno);
+        return false;
+    }
+
+    const VCF_multiallelic_policy multiallelic_policy;
+
+    FILE* bed_file = nullptr;
+    FILE* bim_file = nullptr;
+    std::string bed_pathname;
+    std::string bim_pathname;
+
+    size_t number_of_variants = 0;
+    // The samples written to the .fam file; empty for all samples.
+    std::vector<unsigned> output_samples;
+    std::vector<uint8_t> packed_row;
+
+    std::string chrom;
+    unsigned pos;
+    std::vector<std::string> ids;
+    std::string ref;
+    std::vector<std::string> alts;
+
+    std::string error_message;
+};
+
+#endif /* !defined(VCF_PLINK__HH) */
@@ -27,10 +27,16 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <memory>
+#include <algorithm>
 #include <set>
 #include <cassert>
 #include <climits>
+#include <limits>
 #include <cstring>
+#include <cstdlib>
+#include <cstdint>
 #include <array>
 
 // These constants are returned by the 'parse_...()' methods of VCF_scanner to
@@ -59,6 +65,88 @@ enum class VCF_parsing_event {
           // 'VCF_scanner::clear_line()'.
 };
 
+// The value stored in captured integer variables when the value is missing
+// ('.') or the key is not present on the current data line.
+constexpr int VCF_missing_int = INT_MIN;
+
+// The value stored in captured floating-point variables when the value is
+// missing ('.') or the key is not present. Use 'std::isnan()' to check.
+constexpr float VCF_missing_float = std::numeric_limits<float>::quiet_NaN();
+
+// The fixed-point dosages decoded by 'VCF_scanner::parse_dosage_row()'
+// are multiples of 1 / VCF_dosage_unit (as in PLINK 2), so that 1.0 is
+// stored as 16384.
+constexpr unsigned VCF_dosage_unit = 16384;
+
+// The fixed-point dosage stored for a missing value.
+constexpr uint16_t VCF_missing_dosage = UINT16_MAX;
+
+// Allele index stored in a VCF_genotype_matrix for a missing allele ('.').
+constexpr int8_t VCF_gt_missing = -1;
+
+// Padding stored in a VCF_genotype_matrix after the alleles of a sample
+// whose ploidy is lower than that of the matrix.
+constexpr int8_t VCF_gt_vector_end = -2;
+
+// 2-bit genotype codes stored by 'VCF_scanner::parse_packed_gt_row()'.
+// The codes and their packing (four samples per byte, the first sample
+// in the least significant bits) follow the PLINK .bed format with the
+// ALT allele as A1 and the REF allele as A2.
+constexpr unsigned VCF_packed_gt_hom_alt = 0;
+constexpr unsigned VCF_packed_gt_missing = 1;
+constexpr unsigned VCF_packed_gt_het = 2;
+constexpr unsigned VCF_packed_gt_hom_ref = 3;
+
+// The filter ID of "PASS". See 'VCF_scanner::get_filter_names()'.
+constexpr unsigned VCF_pass_filter_id = 0;
+
+// How 'VCF_scanner::parse_packed_gt_row()' encodes genotypes
+// that refer to the second or subsequent ALT allele.
+enum class VCF_multiallelic_policy {
+    as_missing, // Encode such genotypes as missing.
+    collapse_alts, // Treat all ALT alleles as one.
+    error // Return an error.
+};
+
+// The type and the number of values of an INFO or FORMAT key as declared
+// by the respective '##INFO' or '##FORMAT' meta-information line.
+struct VCF_key_definition {
+    enum Data_type {
+        integer_type,
+        float_type,
+        flag_type,
+        character_type,
+        string_type
+    };
+    Data_type data_type;
+
+    enum Number_of_values {
+        exact_number, // The number of values is given by 'number'.
+        one_per_alt, // Number=A
+        one_per_allele, // Number=R
+        one_per_genotype, // Number=G
+        unbound // Number=.
+    };
+    Number_of_values number_of_values;
+    unsigned number;
+
+    std::string description;
+};
+
+// A contig declared by a '##contig' meta-information line.
+struct VCF_contig {
+    std::string id;
+
+    // The length of the contig or zero if the length is not specified.
+    unsigned long long length;
+};
+
+// A filter declared by a '##FILTER' meta-information line.
+struct VCF_filter {
+    std::string id;
+    std::string description;
+};
+
 #include "impl/header.hh"
 
 // Metadata extracted from the VCF header.
@@ -87,6 +175,442 @@ public:
     {
         return sample_ids;
     }
+
+    typedef std::map<std::string, VCF_key_definition> Key_definitions;
+
+    // Returns the INFO keys declared by the '##INFO' lines.
+    const Key_definitions& get_info_definitions() const
+    {
+        return info_definitions;
+    }
+
+    // Returns the FORMAT keys declared by the '##FORMAT' lines.
+    const Key_definitions& get_format_definitions() const
+    {
+        return format_definitions;
+    }
+
+    // Returns the contigs declared in the header in the order
+    // of their declaration.
+    const std::vector<VCF_contig>& get_contigs() const
+    {
+        return contigs;
+    }
+
+    // Returns the filters declared by the '##FILTER' lines in the
+    // order of their declaration.
+    const std::vector<VCF_filter>& get_filters() const
+    {
+        return filters;
+    }
+};
+
+// A set of the IDs assigned by VCF_scanner to FILTER values or INFO
+// flags, stored as a bitmap: bit 'id % 64' of word 'id / 64' is set
+// if the set contains 'id'.
+class VCF_id_set
+{
+public:
+    bool contains(unsigned id) const
+    {
+        return id / 64 < words.size() && (words[id / 64] >> (id % 64) & 1);
+    }
+
+    bool empty() const
+    {
+        for (uint64_t word : words) {
+            if (word != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void insert(unsigned id)
+    {
+        if (id / 64 >= words.size()) {
+            words.resize(id / 64 + 1, 0);
+        }
+        words[id / 64] |= uint64_t(1) << (id % 64);
+    }
+
+    // Removes all IDs without releasing the memory.
+    void clear()
+    {
+        std::fill(words.begin(), words.end(), 0);
+    }
+
+    const std::vector<uint64_t>& get_words() const
+    {
+        return words;
+    }
+
+private:
+    std::vector<uint64_t> words;
+};
+
+// Dense matrix of the genotypes of a batch of variants, which can be
+// filled by 'VCF_scanner::parse_gt_row()'. Each row holds the allele
+// indices of all samples for one variant: 'ploidy' consecutive elements
+// per sample. Missing alleles are stored as VCF_gt_missing, and samples
+// with fewer alleles are padded with VCF_gt_vector_end. Each row also
+// has a bitmap with one bit per sample (the least significant bit of
+// the first byte for the first sample), which is set if the genotype
+// of the sample is phased.
+class VCF_genotype_matrix
+{
+public:
+    explicit VCF_genotype_matrix(unsigned samples, unsigned ploidy = 2) :
+        number_of_samples(samples),
+        sample_ploidy(ploidy),
+        row_size((size_t) samples * ploidy),
+        phasing_row_size((samples + 7) / 8)
+    {
+    }
+
+    unsigned get_number_of_samples() const
+    {
+        return number_of_samples;
+    }
+
+    unsigned get_ploidy() const
+    {
+        return sample_ploidy;
+    }
+
+    size_t get_number_of_variants() const
+    {
+        return number_of_variants;
+    }
+
+    // Returns the number of bytes in each row of the phasing bitmap.
+    size_t get_phasing_row_size() const
+    {
+        return phasing_row_size;
+    }
+
+    // Removes all rows without releasing the memory.
+    void clear()
+    {
+        number_of_variants = 0;
+        alleles.clear();
+        phasing.clear();
+    }
+
+    // Appends a row filled with missing values and returns its index.
+    size_t add_variant()
+    {
+        alleles.resize(alleles.size() + row_size, VCF_gt_missing);
+        phasing.resize(phasing.size() + phasing_row_size, 0);
+        return number_of_variants++;
+    }
+
+    void remove_last_variant()
+    {
+        if (number_of_variants > 0) {
+            --number_of_variants;
+            alleles.resize(alleles.size() - row_size);
+            phasing.resize(phasing.size() - phasing_row_size);
+        }
+    }
+
+    int8_t* get_alleles(size_t variant)
+    {
+        return alleles.data() + variant * row_size;
+    }
+
+    const int8_t* get_alleles(size_t variant) const
+    {
+        return alleles.data() + variant * row_size;
+    }
+
+    uint8_t* get_phasing(size_t variant)
+    {
+        return phasing.data() + variant * phasing_row_size;
+    }
+
+    const uint8_t* get_phasing(size_t variant) const
+    {
+        return phasing.data() + variant * phasing_row_size;
+    }
+
+    int8_t get_allele(size_t variant, unsigned sample, unsigned i) const
+    {
+        return get_alleles(variant)[(size_t) sample * sample_ploidy + i];
+    }
+
+    bool is_phased(size_t variant, unsigned sample) const
+    {
+        return (get_phasing(variant)[sample / 8] >> (sample % 8)) & 1;
+    }
+
+    // Returns the entire matrix in row-major order.
+    const std::vector<int8_t>& get_allele_data() const
+    {
+        return alleles;
+    }
+
+    // Returns the phasing bitmaps of all rows.
+    const std::vector<uint8_t>& get_phasing_data() const
+    {
+        return phasing;
+    }
+
+private:
+    unsigned number_of_samples;
+    unsigned sample_ploidy;
+    size_t row_size;
+    size_t phasing_row_size;
+    size_t number_of_variants = 0;
+    std::vector<int8_t> alleles;
+    std::vector<uint8_t> phasing;
+};
+
+// The genotypes of a data line that are not homozygous reference,
+// decoded by 'VCF_scanner::parse_sparse_gt_row()'. In large cohorts,
+// most genotypes at most sites are '0/0', so this representation is
+// much smaller than a row of VCF_genotype_matrix. Samples without
+// a GT value are listed as missing.
+struct VCF_sparse_gt_row {
+    // The maximum number of alleles per sample.
+    unsigned ploidy;
+
+    // The indices of the listed samples in increasing order.
+    std::vector<unsigned> samples;
+
+    // 'ploidy' alleles for each listed sample in the format of
+    // VCF_genotype_matrix: VCF_gt_missing for missing alleles and
+    // VCF_gt_vector_end for padding.
+    std::vector<int8_t> alleles;
+
+    // Whether the genotype of each listed sample is phased.
+    std::vector<bool> phased;
+};
+
+// A condition on the genotypes of a data line that is evaluated by
+// 'VCF_scanner::evaluate_gt_predicate()': at least 'min_samples'
+// samples have a genotype of the specified class. For example,
+// {VCF_gt_predicate::carrier, 1} is true if any sample carries an
+// ALT allele.
+struct VCF_gt_predicate {
+    enum Genotype_class {
+        // At least one allele is an ALT allele.
+        carrier,
+        // No allele is missing, and the alleles are not all
+        // the same, for example, '0/1' or '1/2'.
+        het,
+        // All alleles are the same ALT allele.
+        hom_alt
+    } genotype_class;
+
+    unsigned min_samples;
+};
+
+// Per-site genotype statistics computed by 'VCF_scanner::count_alleles()'.
+struct VCF_allele_counts {
+    // The number of called alleles by allele index (REF is at index 0).
+    std::vector<unsigned> allele_counts;
+
+    // The total number of called alleles (AN).
+    unsigned number_of_called_alleles;
+
+    // The number of samples with each kind of genotype. A genotype is
+    // missing if at least one of its alleles is missing or if the
+    // sample has no GT value.
+    unsigned hom_ref;
+    unsigned het;
+    unsigned hom_alt;
+    unsigned missing;
+};
+
+#include "impl/record.hh"
+
+// The mandatory fields of a data line located by 'VCF_scanner::parse_record()'.
+// The record keeps a copy of the fields and the boundaries between them;
+// the values of the fields are extracted only when their accessor methods
+// are called for the first time. This way, the fields that are not used
+// are never split or copied into separate strings. The record remains
+// valid until it is passed to 'parse_record()' again, and the accessors
+// must not be called before that.
+//
+// List fields (ID, ALT, FILTER, and INFO) are split the same way the
+// respective 'VCF_scanner' methods split them.
+class VCF_record final : public VCF_record_impl
+{
+public:
+    const std::string& get_chrom()
+    {
+        if (needs_decoding(chrom_field)) {
+            size_t len;
+            const char* field = get_field(chrom_field, &len);
+            chrom.assign(field, len);
+        }
+        return chrom;
+    }
+
+    // Returns false if POS is not a valid unsigned integer.
+    bool get_pos(unsigned* pos) const
+    {
+        size_t len;
+        const char* field = get_field(pos_field, &len);
+
+        return parse_pos(field, len, pos);
+    }
+
+    const std::vector<std::string>& get_ids()
+    {
+        if (needs_decoding(id_field)) {
+            split_field(id_field, ';', &ids);
+        }
+        return ids;
+    }
+
+    const std::string& get_ref()
+    {
+        if (needs_decoding(ref_field)) {
+            size_t len;
+            const char* field = get_field(ref_field, &len);
+            ref.assign(field, len);
+        }
+        return ref;
+    }
+
+    const std::vector<std::string>& get_alts()
+    {
+        if (needs_decoding(alt_field)) {
+            split_field(alt_field, ',', &alts);
+        }
+        return alts;
+    }
+
+    // Returns the text of the QUAL field or an empty string
+    // if the value is missing.
+    const std::string& get_quality()
+    {
+        if (needs_decoding(quality_field)) {
+            size_t len;
+            const char* field = get_field(quality_field, &len);
+            if (is_dot(field, field + len)) {
+                quality.clear();
+            } else {
+                quality.assign(field, len);
+            }
+        }
+        return quality;
+    }
+
+    // Converts the QUAL field to 'float'. VCF_missing_float is
+    // returned if the value is missing. Returns false if QUAL is
+    // not a valid floating-point number.
+    bool get_quality(float* quality) const
+    {
+        size_t len;
+        const char* field = get_field(quality_field, &len);
+
+        return VCF_float_parser::parse(field, field + len, quality);
+    }
+
+    const std::vector<std::string>& get_filters()
+    {
+        if (needs_decoding(filter_field)) {
+            split_field(filter_field, ';', &filters);
+        }
+        return filters;
+    }
+
+    // Returns the INFO entries in the format of 'VCF_scanner::get_info()'.
+    const std::vector<std::string>& get_info()
+    {
+        if (needs_decoding(info_field)) {
+            split_field(info_field, ';', &info);
+        }
+        return info;
+    }
+};
+
+// Mandatory fields of a batch of data lines filled by
+// 'VCF_scanner::parse_batch()' and stored column by column: one array
+// element per record for CHROM, POS, and QUAL, a bitmap row per record
+// for FILTER, and a single byte arena for the ID, REF, ALT, and INFO
+// text. CHROM and FILTER values are replaced with the IDs assigned by
+// the parser (see 'VCF_scanner::get_contig_names()' and
+// 'VCF_scanner::get_filter_names()').
+class VCF_record_batch final : public VCF_record_batch_impl
+{
+public:
+    size_t get_number_of_records() const
+    {
+        return get_number_of_records_impl();
+    }
+
+    // Removes all records without releasing the memory.
+    // The CHROM and FILTER dictionaries are preserved.
+    void clear()
+    {
+        clear_impl();
+    }
+
+    // Returns the contig ID of each record.
+    const std::vector<unsigned>& get_chrom_ids() const
+    {
+        return chrom_ids;
+    }
+
+    const std::vector<unsigned>& get_positions() const
+    {
+        return positions;
+    }
+
+    // Returns the QUAL value of each record; missing values
+    // are represented by VCF_missing_float.
+    const std::vector<float>& get_qualities() const
+    {
+        return qualities;
+    }
+
+    // The following methods return the raw text of the respective
+    // field of a record. The text is not null-terminated.
+
+    const char* get_ids(size_t record, size_t* len) const
+    {
+        return get_text(record, id_text, len);
+    }
+
+    const char* get_ref(size_t record, size_t* len) const
+    {
+        return get_text(record, ref_text, len);
+    }
+
+    const char* get_alts(size_t record, size_t* len) const
+    {
+        return get_text(record, alt_text, len);
+    }
+
+    const char* get_info(size_t record, size_t* len) const
+    {
+        return get_text(record, info_text, len);
+    }
+
+    // Returns the number of 64-bit words in each row of the FILTER
+    // bitmap.
+    size_t get_filter_row_size() const
+    {
+        return filter_words;
+    }
+
+    // Returns the FILTER bitmap row of a record. Bit 'i % 64' of
+    // word 'i / 64' is set if filter 'i' is listed in the record.
+    const uint64_t* get_filters(size_t record) const
+    {
+        return filter_bits.data() + record * filter_words;
+    }
+
+    bool has_filter(size_t record, unsigned filter_id) const
+    {
+        return filter_id < filter_words * 64 &&
+                (get_filters(record)[filter_id / 64] >> (filter_id % 64) &
+                        1) != 0;
+    }
 };
 
 // TODO FIXME Not used yet.
@@ -171,6 +695,20 @@ public:
         return parse_header_impl(header);
     }
 
+    // Prepares this parser to read data lines without parsing the header.
+    // The header must have been parsed beforehand by another instance of
+    // VCF_scanner. This allows several parsers to process different parts
+    // of the same file concurrently.
+    //
+    // The method must be called instead of 'parse_header()' and always
+    // returns 'need_more_data'. The first buffer passed to 'feed()' must
+    // begin at the start of a data line. Line numbers returned by
+    // 'get_line_number()' are counted from that line.
+    VCF_parsing_event start_at_data_line(const VCF_header& header)
+    {
+        return start_at_data_line_impl(header);
+    }
+
     // Returns true if the entire input stream has been successfully parsed.
     // The method returns false if the VCF file has at least one more data line
     // to parse.
@@ -179,6 +717,37 @@ public:
         return tokenizer.at_eof();
     }
 
+    // Locates the eight mandatory fields of the current data line and
+    // stores them in 'record' without extracting their values. This
+    // method can be used instead of 'parse_loc()', 'parse_ids()',
+    // 'parse_alleles()', 'parse_quality()', 'parse_filters()', and
+    // 'parse_info()'; it must be called at the beginning of a data line.
+    // Only the presence of the fields is checked; the values are
+    // validated by the accessors of VCF_record. The genotype fields, if
+    // any, can be parsed after this call as usual. The number of ALT
+    // alleles is determined, so that the allele indices in GT values
+    // are checked.
+    VCF_parsing_event parse_record(VCF_record* record)
+    {
+        return parse_record_impl(record);
+    }
+
+    // Clears 'batch' and fills it with the mandatory fields of up to
+    // 'max_records' data lines starting with the current one. The
+    // genotype fields of these lines are skipped. When this method
+    // returns 'ok', the parser is at the beginning of the next data
+    // line, so neither 'clear_line()' nor 'parse_loc()' must be called
+    // for the lines in the batch. The batch contains fewer records
+    // than requested only at the end of the input stream.
+    //
+    // If a data line is malformed, an error is returned and the batch
+    // contains the lines that precede it. The malformed line can then
+    // be skipped with 'clear_line()'.
+    VCF_parsing_event parse_batch(VCF_record_batch* batch, size_t max_records)
+    {
+        return parse_batch_impl(batch, max_records);
+    }
+
     // Parses the CHROM and the POS fields and stores the parsed values into
     // the variables pointed to by 'chrom' and 'pos'.  The lifespan of those
     // variables must exceed this 'parse_loc()' call as well as all 'feed()'
@@ -188,6 +757,36 @@ public:
         return parse_loc_impl(chrom, pos);
     }
 
+    // Same as above, but instead of copying CHROM into a string, stores
+    // the ID of the contig into the variable pointed to by 'contig_id'.
+    // Contigs declared by the '##contig' header lines have the IDs that
+    // match their positions in 'VCF_header::get_contigs()'; contigs that
+    // are not declared receive the next available IDs when they first
+    // appear. When CHROM is the same as on the previous line, the ID is
+    // found without a dictionary lookup.
+    //
+    // The IDs of undeclared contigs are assigned by each scanner
+    // separately, so scanners that read different ranges of the same
+    // file (like those of VCF_range_scheduler) may disagree on them.
+    VCF_parsing_event parse_loc(unsigned* contig_id, unsigned* pos)
+    {
+        return parse_loc_impl(contig_id, pos);
+    }
+
+    // Returns the names of all contigs known to the parser.
+    // The position of each name in the vector is its contig ID.
+    const std::vector<std::string>& get_contig_names() const
+    {
+        return contig_dictionary.get_names();
+    }
+
+    // Returns the ID of the contig or UINT_MAX if the contig
+    // has not been encountered.
+    unsigned find_contig_id(const std::string& contig_name) const
+    {
+        return contig_dictionary.find_id(contig_name);
+    }
+
     // Parses the ID field into the 'ids' array.  The lifespan of the array
     // must exceed this 'parse_ids()' call as well as all 'feed()' calls that
     // may be required to finish parsing the ID field.
@@ -207,12 +806,19 @@ public:
 
     // Parses the QUAL field and returns its original string representation as
     // it appears in the VCF file or an empty string if the value is missing.
-    // The 'std::stof()' function can be used to convert that value to 'float'.
+    // Use the overload below to receive the value as a 'float'.
     VCF_parsing_event parse_quality(std::string* quality_str)
     {
         return parse_quality_impl(quality_str);
     }
 
+    // Parses the QUAL field as a 'float' without copying its text.
+    // VCF_missing_float is returned if the value is missing.
+    VCF_parsing_event parse_quality(float* quality)
+    {
+        return parse_quality_impl(quality);
+    }
+
     // Parses and returns the FILTER field. The word "PASS" is returned
     // when the current record passed all filters.
     VCF_parsing_event parse_filters(std::vector<std::string>* filters)
@@ -220,6 +826,34 @@ public:
         return parse_filters_impl(filters);
     }
 
+    // Parses the FILTER field into a set of filter IDs.  Unlike the
+    // string version, this method does not copy the filter names.
+    // PASS has the ID 'VCF_pass_filter_id'; the filters declared by
+    // the '##FILTER' header lines are numbered in the order of
+    // declaration, and undeclared filters receive the next available
+    // IDs when they first appear.  The set is empty if the value is
+    // missing.  As with contig IDs, the IDs of undeclared filters are
+    // assigned by each scanner separately.
+    VCF_parsing_event parse_filters(VCF_id_set* filter_ids)
+    {
+        return parse_filters_impl(filter_ids);
+    }
+
+    // Returns the names of all filters known to the parser.
+    // The position of each name in the vector is its filter ID.
+    // The IDs are shared with 'VCF_record_batch'.
+    const std::vector<std::string>& get_filter_names() const
+    {
+        return filter_dictionary.get_names();
+    }
+
+    // Returns the ID of the filter or UINT_MAX if the filter
+    // has not been encountered.
+    unsigned find_filter_id(const std::string& filter_name) const
+    {
+        return filter_dictionary.find_id(filter_name);
+    }
+
     // Parses the INFO key-value pairs.
     VCF_parsing_event parse_info()
     {
@@ -232,6 +866,153 @@ public:
         return info;
     }
 
+    // The 'capture_info_...()' methods request decoding of the specified
+    // INFO key into a variable supplied by the caller. The value is decoded
+    // by 'parse_info()' in the same pass that splits the INFO field.
+    //
+    // The key must be declared by an '##INFO' header line with a compatible
+    // Type; otherwise, the method returns false and does nothing. Scalar
+    // variables can only receive keys declared with Number=1. The number of
+    // values received by a vector is checked against the declared Number
+    // (including A and R if 'parse_alleles()' was called for the line).
+    //
+    // Unlike 'capture_gt()', INFO captures are requested once after the
+    // header has been parsed and remain in effect for all data lines. The
+    // variables must outlive the scanner. Every 'parse_info()' call first
+    // resets the captured variables: flags to false, numbers to
+    // VCF_missing_int or VCF_missing_float, strings and vectors to empty.
+    // Missing values ('.') are decoded the same way.
+
+    // Captures a key of type Flag.
+    bool capture_info_flag(const char* key, bool* value)
+    {
+        return capture_info_impl(
+                key, vcf_flag, false, &Value_capture::flag, value);
+    }
+
+    // Captures a single-valued key of type Integer.
+    bool capture_info_int(const char* key, int* value)
+    {
+        return capture_info_impl(
+                key, vcf_integer, false, &Value_capture::int_scalar, value);
+    }
+
+    // Captures a key of type Integer with any Number.
+    bool capture_info_ints(const char* key, std::vector<int>* values)
+    {
+        return capture_info_impl(
+                key, vcf_integer, true, &Value_capture::int_vector, values);
+    }
+
+    // Captures a single-valued key of type Float or Integer.
+    bool capture_info_float(const char* key, float* value)
+    {
+        return capture_info_impl(
+                key, vcf_float, false, &Value_capture::float_scalar, value);
+    }
+
+    // Captures a key of type Float or Integer with any Number.
+    bool capture_info_floats(const char* key, std::vector<float>* values)
+    {
+        return capture_info_impl(
+                key, vcf_float, true, &Value_capture::float_vector, values);
+    }
+
+    // Captures the raw text of a single-valued key of any type
+    // except Flag.
+    bool capture_info_string(const char* key, std::string* value)
+    {
+        return capture_info_impl(
+                key, vcf_string, false, &Value_capture::string_scalar, value);
+    }
+
+    // Captures the comma-separated values of a key of any type
+    // except Flag as strings.
+    bool capture_info_strings(
+            const char* key, std::vector<std::string>* values)
+    {
+        return capture_info_impl(
+                key, vcf_string, true, &Value_capture::string_vector, values);
+    }
+
+    // Requests that 'parse_info()' and 'parse_captured_info()' collect
+    // the INFO keys that appear without a value (that is, the flags)
+    // into 'flags' as IDs.  The flags declared by the '##INFO' header
+    // lines are numbered in the order of declaration; other keys without
+    // values receive the next available IDs when they first appear.
+    // The IDs of such keys are assigned by each scanner separately.
+    // Passing nullptr stops the collection.
+    void capture_info_flags(VCF_id_set* flags)
+    {
+        info_flags = flags;
+    }
+
+    // Returns the keys of all INFO flags known to the parser.
+    // The position of each key in the vector is its flag ID.
+    const std::vector<std::string>& get_info_flag_names() const
+    {
+        return info_flag_dictionary.get_names();
+    }
+
+    // Returns the ID of the INFO flag or UINT_MAX if the flag
+    // has not been encountered.
+    unsigned find_info_flag_id(const std::string& key) const
+    {
+        return info_flag_dictionary.find_id(key);
+    }
+
+    // Decodes the captured INFO keys like 'parse_info()', but does
+    // not store the INFO field: 'get_info()' returns an empty vector.
+    // The values of the keys that have not been captured are skipped
+    // without being copied, which makes this method much faster than
+    // 'parse_info()' when only a few of many keys are needed.
+    VCF_parsing_event parse_captured_info()
+    {
+        return parse_captured_info_impl();
+    }
+
+    // Restricts genotype parsing to the samples with the specified IDs.
+    // Genotype columns of the other samples are skipped without being
+    // decoded. 'parse_genotype()' proceeds directly to the next selected
+    // sample, and the output of 'parse_gt_row()', 'parse_packed_gt_row()',
+    // and 'count_alleles()' contains only the selected samples in the
+    // order of their columns in the VCF file, regardless of the order
+    // of the IDs in 'sample_ids'. Repeated IDs select the sample once.
+    // The genotype columns that follow the last selected sample are
+    // not validated.
+    //
+    // The header must have been parsed or passed to 'start_at_data_line()'
+    // beforehand. The selection must not be changed while a data line
+    // is being parsed. Returns false and keeps the current selection if
+    // 'sample_ids' is empty or if any of the IDs is not present in the
+    // header. Use 'select_all_samples()' to cancel the selection.
+    bool select_samples(const std::vector<std::string>& sample_ids)
+    {
+        return select_samples_impl(sample_ids);
+    }
+
+    // Same as above, but the samples are specified by their indices
+    // in the 'get_sample_ids()' vector of the header. Repeated indices
+    // select the sample once. Returns false if 'sample_indices' is
+    // empty or if any of the indices is out of range.
+    bool select_samples(const std::vector<unsigned>& sample_indices)
+    {
+        return select_samples_impl(sample_indices);
+    }
+
+    // Cancels the effect of 'select_samples()'.
+    void select_all_samples()
+    {
+        selected_samples.clear();
+    }
+
+    // Returns the indices of the selected samples in ascending order
+    // or an empty vector if all samples are selected.
+    const std::vector<unsigned>& get_selected_samples() const
+    {
+        return selected_samples;
+    }
+
     // Parses the genotype format keys.
     VCF_parsing_event parse_genotype_format()
     {
@@ -244,16 +1025,80 @@ public:
     // Enables parsing of GT values in the parse_genotype method.
     // Returns false and does nothing if the GT key was not
     // specified in the FORMAT field.
+    //
+    // Captures apply to the current data line only: they must be
+    // requested again after each 'parse_genotype_format()' call.
     bool capture_gt()
     {
         return capture_gt_impl();
     }
 
-    // TODO bool capture_string(const char* key, std::string* value);
-    // TODO bool capture_strings(const char* key, std::vector<std::string>*
-    // values);
-    // TODO bool capture_int(const char* key, int* value);
-    // TODO bool capture_ints(const char* key, std::vector<int>* values);
+    // The following methods enable decoding of the specified FORMAT
+    // key into a variable supplied by the caller. Like 'capture_gt()',
+    // they must be called after each 'parse_genotype_format()' call
+    // and return false if the key is not present in the FORMAT field.
+    // The variable must remain valid until the end of the data line
+    // or until 'clear_genotype_captures()' is called.
+    // They also return false if the key is declared by a '##FORMAT'
+    // header line with an incompatible Type or, for scalar variables,
+    // with a Number other than 1. The number of values received by a
+    // vector is checked against the declared Number (including A, R,
+    // and G for haploid and diploid samples, if the alleles and GT
+    // have been parsed).
+    //
+    // Every 'parse_genotype()' call first resets the captured variables
+    // the same way 'parse_info()' resets the captured INFO keys. This
+    // also applies to the trailing keys omitted from the genotype field.
+
+    // Captures a single-valued key of type Integer.
+    bool capture_int(const char* key, int* value)
+    {
+        return capture_format_impl(
+                key, vcf_integer, false, &Value_capture::int_scalar, value);
+    }
+
+    // Captures a key of type Integer with any Number.
+    bool capture_ints(const char* key, std::vector<int>* values)
+    {
+        return capture_format_impl(
+                key, vcf_integer, true, &Value_capture::int_vector, values);
+    }
+
+    // Captures a single-valued key of type Float or Integer.
+    bool capture_float(const char* key, float* value)
+    {
+        return capture_format_impl(
+                key, vcf_float, false, &Value_capture::float_scalar, value);
+    }
+
+    // Captures a key of type Float or Integer with any Number.
+    bool capture_floats(const char* key, std::vector<float>* values)
+    {
+        return capture_format_impl(
+                key, vcf_float, true, &Value_capture::float_vector, values);
+    }
+
+    // Captures the raw text of a single-valued key.
+    bool capture_string(const char* key, std::string* value)
+    {
+        return capture_format_impl(
+                key, vcf_string, false, &Value_capture::string_scalar, value);
+    }
+
+    // Captures the comma-separated values of a key as strings.
+    bool capture_strings(const char* key, std::vector<std::string>* values)
+    {
+        return capture_format_impl(
+                key, vcf_string, true, &Value_capture::string_vector, values);
+    }
+
+    // Cancels the effect of 'capture_gt()' and the other FORMAT
+    // capture methods for the rest of the current data line. The
+    // variables are no longer written to.
+    void clear_genotype_captures()
+    {
+        clear_genotype_captures_impl();
+    }
 
     // Parses genotype fields one by one.
     VCF_parsing_event parse_genotype()
@@ -273,13 +1118,154 @@ public:
         return phased_gt;
     }
 
+    // Decodes the GT values of all remaining samples on the current
+    // data line at once. This method can be used instead of calling
+    // 'parse_genotype()' for each sample. The alleles are stored in
+    // the 'alleles' array ('number_of_samples * ploidy' elements) in
+    // the format of VCF_genotype_matrix, and the phasing bits are
+    // stored in the 'phasing' bitmap. Samples whose GT is absent are
+    // reported as missing. It is an error if the ploidy of a sample
+    // exceeds 'ploidy' or if an allele index exceeds 127.
+    //
+    // Both arrays must remain valid until the method (or 'feed()')
+    // returns anything other than 'need_more_data'.
+    VCF_parsing_event parse_gt_row(
+            int8_t* alleles, uint8_t* phasing, unsigned ploidy)
+    {
+        return parse_gt_row_impl(alleles, phasing, ploidy);
+    }
+
+    // Appends a row for the current data line to the matrix and
+    // decodes the GT values of the remaining samples into that row.
+    // The matrix needs a column for every sample returned by
+    // 'get_selected_samples()' or, if all samples are selected, for
+    // every sample of the header. A narrower matrix is an error, and
+    // no row is appended. After other errors, the appended row can
+    // be dropped with 'remove_last_variant()'.
+    VCF_parsing_event parse_gt_row(VCF_genotype_matrix* matrix)
+    {
+        return parse_gt_row_impl(matrix);
+    }
+
+    // Decodes the GT values of all remaining samples on the current
+    // data line into 2-bit codes (see VCF_packed_gt_hom_ref and others).
+    // The 'packed' array must hold '(number_of_samples + 3) / 4' bytes;
+    // it receives a row of a PLINK .bed file. Haploid genotypes are
+    // encoded as homozygous, and genotypes with a missing allele or with
+    // more than two alleles are encoded as missing.
+    VCF_parsing_event parse_packed_gt_row(uint8_t* packed,
+            VCF_multiallelic_policy policy =
+                    VCF_multiallelic_policy::as_missing)
+    {
+        return parse_packed_gt_row_impl(packed, policy);
+    }
+
+    // Accumulates the allele counts and the genotype tallies of all
+    // remaining samples on the current data line without storing
+    // individual genotypes. The 'counts' structure is reset first.
+    // If the alleles have been parsed, 'allele_counts' has an element
+    // for each allele; otherwise, it is only as long as the highest
+    // allele index requires.
+    VCF_parsing_event count_alleles(VCF_allele_counts* counts)
+    {
+        return count_alleles_impl(counts);
+    }
+
+    // Lists the genotypes of all remaining samples on the current data
+    // line that are not homozygous reference (see VCF_sparse_gt_row).
+    // Columns that contain nothing but '0/0' or '0|0' are skipped
+    // without being tokenized when GT is the only FORMAT key. It is an
+    // error if the ploidy of a sample exceeds 'ploidy' or if an allele
+    // index exceeds 127. The 'row' structure is reset first.
+    VCF_parsing_event parse_sparse_gt_row(
+            VCF_sparse_gt_row* row, unsigned ploidy = 2)
+    {
+        return parse_sparse_gt_row_impl(row, ploidy);
+    }
+
+    // Evaluates a predicate on the genotypes of the remaining samples on
+    // the current data line. Parsing stops as soon as the result is
+    // known: when enough matching genotypes have been found or when
+    // too few samples remain. The rest of the line is then skipped by
+    // 'clear_line()', which must be called next, with a single search
+    // for the newline character. Combined with 'select_samples()',
+    // this answers questions like "does this sample carry an ALT
+    // allele at this site" while decoding only a few columns.
+    VCF_parsing_event evaluate_gt_predicate(
+            const VCF_gt_predicate& predicate, bool* result)
+    {
+        return evaluate_gt_predicate_impl(predicate, result);
+    }
+
+    // Decodes the values of a Float FORMAT key, such as DS, GP, or HDS,
+    // for all remaining samples on the current data line at once. Each
+    // sample receives 'values_per_sample' consecutive elements of the
+    // 'dosages' array (for example, 3 for the GP of a biallelic site),
+    // which must hold 'number_of_samples * values_per_sample' elements.
+    // Values without an exponent, like '0.123', are converted directly
+    // from their digits. Missing and absent values are stored as
+    // VCF_missing_float, and it is an error if a sample has a different
+    // number of values. It is also an error if the key is GT or if it
+    // is declared by a '##FORMAT' line with a Type other than Float or
+    // Integer.
+    //
+    // The array must remain valid until the method (or 'feed()')
+    // returns anything other than 'need_more_data'.
+    VCF_parsing_event parse_dosage_row(
+            const char* key, float* dosages, unsigned values_per_sample = 1)
+    {
+        return parse_dosage_row_impl(
+                key, dosages, values_per_sample, VCF_missing_float);
+    }
+
+    // Decodes the dosages like the above method, but stores them as
+    // fixed-point numbers (see VCF_dosage_unit), which take half the
+    // memory. Missing and absent values are stored as VCF_missing_dosage.
+    // It is an error if a value is negative or does not fit.
+    VCF_parsing_event parse_dosage_row(const char* key, uint16_t* dosages,
+            unsigned values_per_sample = 1)
+    {
+        return parse_dosage_row_impl(
+                key, dosages, values_per_sample, VCF_missing_dosage);
+    }
+
+    // Locates the genotype columns of all samples on the current data
+    // line, so that they can be decoded in any order and any number of
+    // times by 'parse_genotype_of()'. This method must be called right
+    // after 'parse_genotype_format()' instead of 'parse_genotype()' or
+    // 'parse_gt_row()'. The rest of the line is scanned for tabs once;
+    // the columns themselves are not decoded. The index remains valid
+    // until 'clear_line()' is called.
+    VCF_parsing_event index_genotypes()
+    {
+        return index_genotypes_impl();
+    }
+
+    // Returns the number of genotype columns found by 'index_genotypes()'.
+    unsigned get_number_of_indexed_genotypes() const
+    {
+        return get_number_of_indexed_genotypes_impl();
+    }
+
+    // Decodes the genotype column of the sample with the specified
+    // index in the 'get_sample_ids()' vector of the header into the
+    // variables registered by 'capture_gt()' and the other capture
+    // methods, the same way 'parse_genotype()' does. Samples whose
+    // columns are missing from the line get their captures reset.
+    // The method never needs more data.
+    VCF_parsing_event parse_genotype_of(unsigned sample_index)
+    {
+        return parse_genotype_of_impl(sample_index);
+    }
+
     // Returns true if at least one more genotype field is available.
     // The caller has an option to either use this method or count the
     // retrieved genotypes to determine when the last genotype on the
-    // current data line has been parsed.
+    // current data line has been parsed. If samples are selected, only
+    // the remaining selected samples are counted.
     bool genotype_available() const
     {
-        return tokenizer.get_terminator() == '\t';
+        return genotype_available_impl();
     }
 
     // Skips the remaining part of the current data line.
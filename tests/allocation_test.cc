@@ -0,0 +1,157 @@
+#include <vcf_scanner/vcf_scanner.hh>
+
+#include "catch.hh"
+
+#include <cstdlib>
+#include <new>
+
+static size_t allocation_count = 0;
+
+// The replacements are not inlined, so that the compiler does not pair
+// the 'malloc()' call with the 'delete' expressions of the callers.
+__attribute__((noinline)) void* operator new(size_t size)
+{
+    ++allocation_count;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+// The lines of this block differ in the number and the length of their
+// list items, so that every list shrinks and grows from line to line.
+static const char data_lines[] =
+        "chr1\t100\trs100;rs101\tACGTACGTACGTACGTACGT\t"
+        "A,AC,ACGTACGTACGTACGTACGT\t50\tPASS\t"
+        "AA=ACGTACGTACGTACGTACGT;AF=0.5,0.25,0.125;CSQ=long_consequence_one,"
+        "long_consequence_two;DB\t"
+        "GT:AD:FT\t0/1:1,2,3,4:long_filter_value_one,long_filter_value_two\n"
+        "chr2\t200\t.\tA\tG\t.\tq10_filter_with_a_long_name\tAF=0.5\tGT\t1|1\n"
+        "chr1\t300\trs300_with_a_long_identifier\tA\tGACGTACGTACGTACGTACGT\t."
+        "\t.\tCSQ=long_consequence_three\tGT:AD:FT\t./.:.:.\n";
+
+static const char vcf_header[] =
+        "##fileformat=VCFv4.2\n"
+        "##INFO=<ID=AF,Number=A,Type=Float,Description=\"AF\">\n"
+        "##INFO=<ID=CSQ,Number=.,Type=String,Description=\"CSQ\">\n"
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tS1\n";
+
+// Returns false if any of the methods fails.
+static bool parse_data_lines(VCF_scanner& vcf_scanner, size_t number_of_lines)
+{
+    static std::string chrom;
+    static unsigned pos;
+    static std::vector<std::string> ids;
+    static std::string ref;
+    static std::vector<std::string> alts;
+    static std::string quality_str;
+    static std::vector<std::string> filters;
+    static std::vector<int> ad;
+    static std::vector<std::string> ft;
+
+    for (size_t line = 0; line < number_of_lines; ++line) {
+        if (vcf_scanner.parse_loc(&chrom, &pos) != VCF_parsing_event::ok ||
+                vcf_scanner.parse_ids(&ids) != VCF_parsing_event::ok ||
+                vcf_scanner.parse_alleles(&ref, &alts) !=
+                        VCF_parsing_event::ok ||
+                vcf_scanner.parse_quality(&quality_str) !=
+                        VCF_parsing_event::ok ||
+                vcf_scanner.parse_filters(&filters) !=
+                        VCF_parsing_event::ok ||
+                vcf_scanner.parse_info() != VCF_parsing_event::ok ||
+                vcf_scanner.parse_genotype_format() !=
+                        VCF_parsing_event::ok) {
+            return false;
+        }
+        vcf_scanner.capture_gt();
+        vcf_scanner.capture_ints("AD", &ad);
+        vcf_scanner.capture_strings("FT", &ft);
+        if (vcf_scanner.parse_genotype() != VCF_parsing_event::ok ||
+                vcf_scanner.clear_line() != VCF_parsing_event::ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool parse_records(VCF_scanner& vcf_scanner, size_t number_of_lines)
+{
+    static VCF_record record;
+
+    for (size_t line = 0; line < number_of_lines; ++line) {
+        if (vcf_scanner.parse_record(&record) != VCF_parsing_event::ok) {
+            return false;
+        }
+        record.get_chrom();
+        record.get_ids();
+        record.get_ref();
+        record.get_alts();
+        record.get_quality();
+        record.get_filters();
+        record.get_info();
+        if (vcf_scanner.clear_line() != VCF_parsing_event::ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("No allocations in steady state")
+{
+    const size_t number_of_lines = 3;
+    const size_t warm_up_blocks = 10;
+    const size_t number_of_blocks = warm_up_blocks * 2 + 6;
+
+    std::string vcf = vcf_header;
+    for (size_t block = 0; block < number_of_blocks; ++block) {
+        vcf += data_lines;
+    }
+
+    VCF_scanner vcf_scanner;
+    VCF_header header;
+
+    REQUIRE(vcf_scanner.parse_header(&header) ==
+            VCF_parsing_event::need_more_data);
+    REQUIRE(vcf_scanner.feed(vcf.data(), (ssize_t) vcf.length()) ==
+            VCF_parsing_event::ok);
+
+    std::vector<float> af;
+    std::vector<std::string> csq;
+    REQUIRE(vcf_scanner.capture_info_floats("AF", &af));
+    REQUIRE(vcf_scanner.capture_info_strings("CSQ", &csq));
+
+    // Buffers are passed between lists with different values, so
+    // it takes a few blocks for all of them to grow large enough.
+    for (size_t block = 0; block < warm_up_blocks; ++block) {
+        REQUIRE(parse_data_lines(vcf_scanner, number_of_lines));
+        REQUIRE(parse_records(vcf_scanner, number_of_lines));
+    }
+
+    size_t allocations_before = allocation_count;
+    bool parsed = parse_data_lines(vcf_scanner, number_of_lines);
+    size_t allocations = allocation_count - allocations_before;
+    REQUIRE(parsed);
+    CHECK(allocations == 0);
+
+    allocations_before = allocation_count;
+    parsed = parse_records(vcf_scanner, number_of_lines);
+    allocations = allocation_count - allocations_before;
+    REQUIRE(parsed);
+    CHECK(allocations == 0);
+
+    VCF_record_batch batch;
+    REQUIRE(vcf_scanner.parse_batch(&batch, number_of_lines) ==
+            VCF_parsing_event::ok);
+
+    allocations_before = allocation_count;
+    const VCF_parsing_event pe =
+            vcf_scanner.parse_batch(&batch, number_of_lines);
+    allocations = allocation_count - allocations_before;
+    REQUIRE(pe == VCF_parsing_event::ok);
+    CHECK(allocations == 0);
+}
@@ -0,0 +1,284 @@
+#include <vcf_scanner/vcf_parallel.hh>
+
+#include "catch.hh"
+
+static unsigned long long sum_range(
+        VCF_executor& executor, unsigned from, unsigned to)
+{
+    if (to - from <= 100) {
+        unsigned long long sum = 0;
+        while (from < to) {
+            sum += from++;
+        }
+        return sum;
+    }
+
+    const unsigned middle = from + (to - from) / 2;
+    unsigned long long left_sum, right_sum;
+
+    VCF_task_group task_group(executor);
+    task_group.run([&] { left_sum = sum_range(executor, from, middle); });
+    right_sum = sum_range(executor, middle, to);
+    task_group.wait();
+
+    return left_sum + right_sum;
+}
+
+TEST_CASE("Nested task groups")
+{
+    VCF_thread_pool thread_pool(4);
+
+    CHECK(thread_pool.get_concurrency() == 4);
+    CHECK(sum_range(thread_pool, 0, 100000) == 4999950000ULL);
+}
+
+TEST_CASE("Independent task groups share the pool")
+{
+    VCF_thread_pool thread_pool(3);
+
+    std::atomic<unsigned> counters[2];
+    counters[0] = counters[1] = 0;
+
+    VCF_task_group first_group(thread_pool), second_group(thread_pool);
+
+    for (unsigned i = 0; i < 1000; ++i) {
+        first_group.run([&] { ++counters[0]; });
+        second_group.run([&] { ++counters[1]; });
+    }
+
+    first_group.wait();
+    CHECK(counters[0] == 1000);
+
+    second_group.wait();
+    CHECK(counters[1] == 1000);
+}
+
+// An executor that runs tasks in the order of submission
+// in the thread that waits for them.
+class Deferred_executor : public VCF_executor
+{
+public:
+    unsigned get_concurrency() const override
+    {
+        return 1;
+    }
+
+    void submit(Task&& task) override
+    {
+        tasks.push_back(std::move(task));
+    }
+
+    bool run_pending_task() override
+    {
+        if (tasks.empty()) {
+            return false;
+        }
+        Task task = std::move(tasks.front());
+        tasks.pop_front();
+        task();
+        return true;
+    }
+
+private:
+    std::deque<Task> tasks;
+};
+
+TEST_CASE("Custom executor")
+{
+    Deferred_executor executor;
+
+    CHECK(sum_range(executor, 0, 1000) == 499500);
+
+    std::string order;
+    {
+        VCF_task_group task_group(executor);
+        task_group.run([&] { order += 'a'; });
+        task_group.run([&] { order += 'b'; });
+        CHECK(order.empty());
+    }
+    CHECK(order == "ab");
+}
+
+TEST_CASE("CPU list parsing")
+{
+    struct Topology : VCF_numa_topology_impl {
+        using VCF_numa_topology_impl::parse_cpu_list;
+    };
+
+    std::vector<unsigned> cpus;
+    CHECK(Topology::parse_cpu_list("0-3,8,10-11\n", &cpus));
+    CHECK(cpus == std::vector<unsigned>({0, 1, 2, 3, 8, 10, 11}));
+
+    cpus.clear();
+    CHECK(Topology::parse_cpu_list("\n", &cpus));
+    CHECK(cpus.empty());
+
+    CHECK(!Topology::parse_cpu_list("3-1", &cpus));
+    CHECK(!Topology::parse_cpu_list("x", &cpus));
+}
+
+TEST_CASE("Node-local task submission")
+{
+    // Two nodes without CPU binding, so that the test
+    // does not depend on the machine topology.
+    VCF_numa_topology topology({{}, {}});
+    CHECK(topology.get_number_of_nodes() == 2);
+
+    VCF_thread_pool thread_pool(topology, 2);
+    CHECK(thread_pool.get_concurrency() == 4);
+    CHECK(thread_pool.get_number_of_nodes() == 2);
+    CHECK(thread_pool.get_current_node() == 0);
+
+    std::atomic<unsigned> tasks_on_node[2];
+    tasks_on_node[0] = tasks_on_node[1] = 0;
+
+    {
+        VCF_task_group task_group(thread_pool);
+
+        for (unsigned node = 0; node < 2; ++node) {
+            thread_pool.submit_to_node(node, [&] {
+                const unsigned current_node = thread_pool.get_current_node();
+                for (unsigned i = 0; i < 100; ++i) {
+                    task_group.run([&, current_node] {
+                        ++tasks_on_node[current_node];
+                    });
+                }
+            });
+        }
+
+        // Let the node tasks spawn their subtasks before waiting.
+        while (tasks_on_node[0] + tasks_on_node[1] < 200) {
+            std::this_thread::yield();
+        }
+    }
+
+    CHECK(tasks_on_node[0] + tasks_on_node[1] == 200);
+}
+
+// A thread pool that exposes the number of tasks queued on each node.
+class Inspectable_thread_pool : public VCF_thread_pool_impl
+{
+public:
+    Inspectable_thread_pool(
+            const VCF_numa_topology& topology, unsigned threads_per_node) :
+        VCF_thread_pool_impl(topology, threads_per_node)
+    {}
+
+    ~Inspectable_thread_pool()
+    {
+        stop_workers();
+    }
+
+    unsigned get_concurrency() const override
+    {
+        return (unsigned) threads.size();
+    }
+
+    void submit(Task&& task) override
+    {
+        submit_impl(std::move(task));
+    }
+
+    bool run_pending_task() override
+    {
+        return run_pending_task_impl();
+    }
+
+    unsigned get_number_of_nodes() const override
+    {
+        return (unsigned) node_workers.size();
+    }
+
+    void submit_to_node(unsigned node, Task&& task) override
+    {
+        submit_to_node_impl(node, std::move(task));
+    }
+
+    unsigned get_current_node() const override
+    {
+        return get_current_node_impl();
+    }
+
+    size_t get_number_of_queued_tasks(unsigned node)
+    {
+        size_t number_of_tasks = 0;
+        for (unsigned worker : node_workers[node]) {
+            std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+            number_of_tasks += queues[worker]->tasks.size();
+        }
+        return number_of_tasks;
+    }
+};
+
+TEST_CASE("Node-local task placement")
+{
+    VCF_numa_topology topology({{}, {}});
+    Inspectable_thread_pool thread_pool(topology, 2);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    unsigned blocked_workers = 0;
+    unsigned submitting_workers = 0;
+    bool released = false;
+    std::atomic<unsigned> finished_tasks{0};
+    std::atomic<unsigned> nodes_of_submitters[2];
+    nodes_of_submitters[0] = nodes_of_submitters[1] = 0;
+
+    // Every worker is kept busy, so that no queued task is taken
+    // before the queues have been inspected.
+    for (unsigned i = 0; i < 4; ++i) {
+        thread_pool.submit([&] {
+            std::unique_lock<std::mutex> lock(mutex);
+            ++blocked_workers;
+            cv.notify_all();
+            cv.wait(lock, [&] { return blocked_workers == 4; });
+            lock.unlock();
+
+            ++nodes_of_submitters[thread_pool.get_current_node()];
+            thread_pool.submit_to_node(1, [&] { ++finished_tasks; });
+
+            lock.lock();
+            ++submitting_workers;
+            cv.notify_all();
+            cv.wait(lock, [&] { return released; });
+        });
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return submitting_workers == 4; });
+    }
+
+    CHECK(nodes_of_submitters[0] == 2);
+    CHECK(nodes_of_submitters[1] == 2);
+
+    // Tasks submitted from either node are queued on the requested one.
+    CHECK(thread_pool.get_number_of_queued_tasks(0) == 0);
+    CHECK(thread_pool.get_number_of_queued_tasks(1) == 4);
+
+    for (unsigned i = 0; i < 10; ++i) {
+        thread_pool.submit_to_node(0, [&] { ++finished_tasks; });
+    }
+    CHECK(thread_pool.get_number_of_queued_tasks(0) == 10);
+    CHECK(thread_pool.get_number_of_queued_tasks(1) == 4);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+    }
+    cv.notify_all();
+
+    while (finished_tasks < 14) {
+        std::this_thread::yield();
+    }
+}
+
+TEST_CASE("Detected topology")
+{
+    VCF_numa_topology topology;
+    REQUIRE(topology.get_number_of_nodes() > 0);
+
+    VCF_thread_pool thread_pool(topology, 1);
+    CHECK(thread_pool.get_number_of_nodes() == topology.get_number_of_nodes());
+    CHECK(sum_range(thread_pool, 0, 10000) == 49995000);
+}
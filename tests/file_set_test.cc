@@ -0,0 +1,133 @@
+#include <vcf_scanner/vcf_parallel.hh>
+
+#include "catch.hh"
+
+static std::string write_test_file(
+        const std::string& pathname, const std::string& contents)
+{
+    FILE* file = fopen(pathname.c_str(), "wb");
+    REQUIRE(file != nullptr);
+    REQUIRE(fwrite(contents.data(), 1, contents.length(), file) ==
+            contents.length());
+    fclose(file);
+    return pathname;
+}
+
+static std::string make_vcf(const char* version, const char* samples,
+        const char* chrom, unsigned number_of_lines)
+{
+    std::string vcf = std::string("##fileformat=") + version +
+            "\n#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT" +
+            samples + '\n';
+    for (unsigned i = 1; i <= number_of_lines; ++i) {
+        vcf += chrom;
+        vcf += '\t' + std::to_string(i) + "\t.\tA\tC\t.\t.\t.\tGT\t0/1\t1/1\n";
+    }
+    return vcf;
+}
+
+TEST_CASE("Header compatibility")
+{
+    VCF_file_set file_set;
+
+    CHECK(file_set.add_file(
+            write_test_file("file_set_chr1.vcf",
+                    make_vcf("VCFv4.2", "\tS1\tS2", "chr1", 3))
+                    .c_str()));
+
+    CHECK(!file_set.add_file(
+            write_test_file("file_set_other_samples.vcf",
+                    make_vcf("VCFv4.2", "\tS1\tS3", "chr2", 3))
+                    .c_str()));
+    CHECK(file_set.get_error() ==
+            "file_set_other_samples.vcf: sample IDs differ "
+            "from those in file_set_chr1.vcf");
+
+    CHECK(!file_set.add_file(
+            write_test_file("file_set_other_version.vcf",
+                    make_vcf("VCFv4.1", "\tS1\tS2", "chr2", 3))
+                    .c_str()));
+    CHECK(file_set.get_error() ==
+            "file_set_other_version.vcf: file format version differs "
+            "from that of file_set_chr1.vcf");
+
+    CHECK(!file_set.add_file("file_set_missing.vcf"));
+    CHECK(file_set.get_error().find("file_set_missing.vcf: ") == 0);
+
+    CHECK(file_set.get_number_of_files() == 1);
+}
+
+TEST_CASE("Sequential and parallel reading of a file set")
+{
+    VCF_file_set file_set;
+
+    std::string chr3 = make_vcf("VCFv4.2", "\tS1\tS2", "chr3", 4);
+    // No newline at the end of the last line.
+    chr3.pop_back();
+
+    REQUIRE(file_set.add_file(
+            write_test_file("file_set_chr1.vcf",
+                    make_vcf("VCFv4.2", "\tS1\tS2", "chr1", 30))
+                    .c_str()));
+    REQUIRE(file_set.add_file(
+            write_test_file("file_set_chr2.vcf",
+                    make_vcf("VCFv4.2", "\tS1\tS2", "chr2", 0))
+                    .c_str()));
+    REQUIRE(file_set.add_file(
+            write_test_file("file_set_chr3.vcf", chr3).c_str()));
+    REQUIRE(file_set.add_file(
+            write_test_file("file_set_chr4.vcf",
+                    make_vcf("VCFv4.2", "\tS1\tS2", "chr4", 100))
+                    .c_str()));
+
+    CHECK(file_set.get_pathname(2) == "file_set_chr3.vcf");
+
+    VCF_scanner scanner;
+    auto parse_to_completion = [&](VCF_parsing_event pe) {
+        while (pe == VCF_parsing_event::need_more_data) {
+            pe = file_set.read_and_feed(scanner);
+        }
+        REQUIRE(pe == VCF_parsing_event::ok);
+    };
+
+    parse_to_completion(scanner.start_at_data_line(file_set.get_header()));
+
+    std::map<std::string, unsigned> line_counts;
+    std::string chrom;
+    unsigned pos;
+    while (!scanner.at_eof()) {
+        parse_to_completion(scanner.parse_loc(&chrom, &pos));
+        CHECK(pos == ++line_counts[chrom]);
+        parse_to_completion(scanner.clear_line());
+    }
+
+    CHECK(line_counts ==
+            std::map<std::string, unsigned>(
+                    {{"chr1", 30}, {"chr3", 4}, {"chr4", 100}}));
+
+    VCF_thread_pool thread_pool(2);
+    std::vector<unsigned> genotype_counts(file_set.get_number_of_files());
+
+    CHECK(file_set.scan_in_parallel(thread_pool,
+            [&](size_t file_index, VCF_scanner& file_scanner,
+                    VCF_range_feeder& feeder) {
+                auto parse = [&](VCF_parsing_event pe) {
+                    while (pe == VCF_parsing_event::need_more_data) {
+                        pe = feeder.read_and_feed(file_scanner);
+                    }
+                    return pe == VCF_parsing_event::ok;
+                };
+                while (!file_scanner.at_eof()) {
+                    if (parse(file_scanner.parse_genotype_format()) &&
+                            file_scanner.capture_gt()) {
+                        while (file_scanner.genotype_available() &&
+                                parse(file_scanner.parse_genotype())) {
+                            ++genotype_counts[file_index];
+                        }
+                    }
+                    parse(file_scanner.clear_line());
+                }
+            }));
+
+    CHECK(genotype_counts == std::vector<unsigned>({60, 0, 8, 200}));
+}
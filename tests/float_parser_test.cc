@@ -0,0 +1,118 @@
+#include <vcf_scanner/vcf_scanner.hh>
+
+#include "catch.hh"
+
+#include <clocale>
+#include <cmath>
+
+static bool parse_float(const std::string& number, float* value)
+{
+    return VCF_float_parser::parse(
+            number.data(), number.data() + number.length(), value);
+}
+
+// Compares the result of the parser with that of 'strtof()'.
+static void check_against_strtof(const std::string& number)
+{
+    float value;
+    REQUIRE(parse_float(number, &value));
+
+    const float expected = strtof(number.c_str(), nullptr);
+    INFO(number);
+    CHECK(memcmp(&value, &expected, sizeof(value)) == 0);
+}
+
+TEST_CASE("Float parsing")
+{
+    float value;
+
+    CHECK(parse_float(".", &value));
+    CHECK(std::isnan(value));
+
+    for (const char* number : {"0", "-0", "+0.0", "1", "-1", "0.5", ".5",
+                 "5.", "12.5", "0.001", "0.998", "1e5", "1E-3", "-2.5e+2",
+                 "1234567.89", "3.4028235e38", "1.17549435e-38",
+                 "1.4e-45", "1e-50", "1e50", "0.1234567890123456789",
+                 "123456789012345678901234567890", "inf", "-nan",
+                 "0x1p3", "-0X1.8P-1",
+                 // The mantissa exceeds 2^53; converting it to double
+                 // first would round the result twice.
+                 "900.7199401855469", "9.007200012207031e2",
+                 // 2^24 + 1 is halfway between two floats.
+                 "16777217", "16777219", "1.6777217e7"}) {
+        check_against_strtof(number);
+    }
+
+    CHECK(std::signbit(parse_float("-0", &value) ? value : 0.0f));
+
+    for (const char* number :
+            {"", "-", "+", "e5", ".e5", "1e", "1e+", "1.5.3", "1x", "..",
+                    "1,5", "1 "}) {
+        INFO(number);
+        CHECK_FALSE(parse_float(number, &value));
+    }
+}
+
+TEST_CASE("Float parsing agrees with strtof")
+{
+    // A simple LCG keeps the test deterministic.
+    uint64_t state = 12345;
+    auto next_random = [&state](unsigned bound) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (unsigned) (state >> 33) % bound;
+    };
+
+    for (int i = 0; i < 100000; ++i) {
+        std::string number;
+        if (next_random(4) == 0) {
+            number += '-';
+        }
+        const unsigned int_digits = next_random(10);
+        for (unsigned d = 0; d < int_digits; ++d) {
+            number += char('0' + next_random(10));
+        }
+        number += '.';
+        const unsigned frac_digits = next_random(12) + 1;
+        for (unsigned d = 0; d < frac_digits; ++d) {
+            number += char('0' + next_random(10));
+        }
+        if (next_random(3) == 0) {
+            number += 'e' + std::to_string((int) next_random(61) - 30);
+        }
+        check_against_strtof(number);
+    }
+}
+
+TEST_CASE("Float parsing does not depend on the locale")
+{
+    static const char* const numbers[] = {"0.1234567890123456789",
+            "1.5e-50", "-0x1.8p-1", "900.7199401855469", "2.5"};
+
+    float expected[sizeof(numbers) / sizeof(*numbers)];
+    for (size_t i = 0; i < sizeof(numbers) / sizeof(*numbers); ++i) {
+        REQUIRE(parse_float(numbers[i], &expected[i]));
+    }
+
+    const char* locale = nullptr;
+    for (const char* name : {"de_DE.UTF-8", "de_DE.utf8", "de_DE",
+                 "fr_FR.UTF-8", "fr_FR.utf8", "fr_FR"}) {
+        if ((locale = setlocale(LC_NUMERIC, name)) != nullptr) {
+            break;
+        }
+    }
+    if (locale == nullptr) {
+        WARN("No locale with a decimal comma is available");
+        return;
+    }
+
+    float value;
+    for (size_t i = 0; i < sizeof(numbers) / sizeof(*numbers); ++i) {
+        INFO(numbers[i]);
+        CHECK(parse_float(numbers[i], &value));
+        CHECK(memcmp(&value, &expected[i], sizeof(value)) == 0);
+    }
+    // The decimal comma of the locale is not accepted.
+    CHECK_FALSE(parse_float("12345678901234567890,5", &value));
+
+    setlocale(LC_NUMERIC, "C");
+}
@@ -0,0 +1,805 @@
+#include "test_plan.hh"
+
+static const char genotype_test_vcf[] = R"(##fileformat=VCFv4.2
+##FORMAT=<ID=GT,Number=1,Type=String,Description="Genotype">
+##FORMAT=<ID=DP,Number=1,Type=Integer,Description="Read depth">
+##FORMAT=<ID=GQ,Number=1,Type=Integer,Description="Genotype quality">
+##FORMAT=<ID=AD,Number=R,Type=Integer,Description="Allelic depths">
+##FORMAT=<ID=PL,Number=G,Type=Integer,Description="Genotype likelihoods">
+##FORMAT=<ID=FT,Number=1,Type=String,Description="Sample filter">
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO	FORMAT	S1	S2
+1	100	.	A	G	.	.	.	GT:DP:GQ:AD:PL:FT	0/1:10:20:4,6:10,0,20:PASS	1|1:.:.:.:.:.
+1	200	.	A	G,T	.	.	.	GT:DP:AD:XY	0/2:7:1,2,3:foo	1
+1	300	.	A	G	.	.	.	GT:PL	0/1:1,2,3	0:1,2,3
+1	400	.	A	G	.	.	.	DP:GT	x:0/1	./.
+1	500	.	A	G	.	.	.	GT:GQ	0/0:1.5	0/0:99)";
+
+static std::string dump_format_captures(
+        const std::string& vcf, size_t chunk_size)
+{
+    VCF_reader vcf_reader(vcf, chunk_size);
+    VCF_scanner vcf_scanner;
+    VCF_header header;
+
+    std::stringstream dump;
+
+    auto parse = [&](VCF_parsing_event pe) {
+        if (pe == VCF_parsing_event::need_more_data) {
+            pe = vcf_reader.read_and_feed(vcf_scanner);
+        }
+        if (pe == VCF_parsing_event::error) {
+            dump << "E:" << vcf_scanner.get_error() << std::endl;
+            return false;
+        }
+        return true;
+    };
+
+    REQUIRE(parse(vcf_scanner.parse_header(&header)));
+
+    std::string ref;
+    std::vector<std::string> alts;
+
+    while (!vcf_scanner.at_eof()) {
+        if (!parse(vcf_scanner.parse_alleles(&ref, &alts)) ||
+                !parse(vcf_scanner.parse_genotype_format())) {
+            parse(vcf_scanner.clear_line());
+            continue;
+        }
+
+        int dp;
+        float gq;
+        std::vector<int> ad, pl;
+        std::string ft, xy;
+
+        const bool gt_captured = vcf_scanner.capture_gt();
+        const bool dp_captured = vcf_scanner.capture_int("DP", &dp);
+        const bool gq_captured = vcf_scanner.capture_float("GQ", &gq);
+        const bool ad_captured = vcf_scanner.capture_ints("AD", &ad);
+        const bool pl_captured = vcf_scanner.capture_ints("PL", &pl);
+        const bool ft_captured = vcf_scanner.capture_string("FT", &ft);
+        // Keys without a definition can be captured too.
+        const bool xy_captured = vcf_scanner.capture_string("XY", &xy);
+
+        // Type and number mismatches.
+        int ad_scalar;
+        std::vector<int> ft_ints;
+        CHECK(!vcf_scanner.capture_int("AD", &ad_scalar));
+        CHECK(!vcf_scanner.capture_ints("FT", &ft_ints));
+
+        while (vcf_scanner.genotype_available()) {
+            if (!parse(vcf_scanner.parse_genotype())) {
+                break;
+            }
+            if (gt_captured) {
+                dump << "GT=";
+                dump_list(dump, vcf_scanner.get_gt());
+            }
+            if (dp_captured) {
+                dump << ";DP=" << dp;
+            }
+            if (gq_captured) {
+                dump << ";GQ=" << gq;
+            }
+            if (ad_captured) {
+                dump << ";AD=";
+                dump_list(dump, ad);
+            }
+            if (pl_captured) {
+                dump << ";PL=";
+                dump_list(dump, pl);
+            }
+            if (ft_captured) {
+                dump << ";FT=" << ft;
+            }
+            if (xy_captured) {
+                dump << ";XY=" << xy;
+            }
+            dump << std::endl;
+        }
+        parse(vcf_scanner.clear_line());
+    }
+
+    return dump.str();
+}
+
+TEST_CASE("Typed FORMAT capture")
+{
+    static const char missing_int[] = "-2147483648";
+
+    const std::string expected = std::string() +
+            "GT=[0,1];DP=10;GQ=20;AD=[4,6];PL=[10,0,20];FT=PASS\n" +
+            "GT=[1,1];DP=" + missing_int + ";GQ=nan;AD=[];PL=[];FT=\n" +
+            "GT=[0,2];DP=7;AD=[1,2,3];XY=foo\n" +
+            "GT=[1];DP=" + missing_int + ";AD=[];XY=\n" +
+            "GT=[0,1];PL=[1,2,3]\n" +
+            "E:Unexpected number of values of FORMAT key 'PL'\n" +
+            "E:Invalid integer value of FORMAT key 'DP'\n" +
+            "GT=[0,0];GQ=1.5\n" + "GT=[0,0];GQ=99\n";
+
+    std::string vcf(genotype_test_vcf);
+
+    for (size_t chunk_size = 1; chunk_size <= vcf.length(); ++chunk_size) {
+        CHECK(dump_format_captures(vcf, chunk_size) == expected);
+    }
+}
+
+TEST_CASE("Integer lists")
+{
+    // Each sample holds a single list, so that every sample
+    // starts at a different offset in the input buffer.
+    static const char* const lists[] = {"0", "7", "1234567", "12345678",
+            "123456789", "2147483647", "-5", "+5", "01", ".", "1,.,3",
+            "10,0,20", "99,1234567,12345678,0", "1,2,3,4,5,6,7,8,9,10,11",
+            "2147483648", "1,,3", "1a", "1,", ",1", "-", "1.5", "1,2a,3"};
+
+    std::string vcf = "##fileformat=VCFv4.2\n"
+                      "##FORMAT=<ID=XI,Number=.,Type=Integer,"
+                      "Description=\"List\">\n"
+                      "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\t"
+                      "FORMAT\tS1\n";
+    for (const char* list : lists) {
+        vcf += "1\t100\t.\tA\tG\t.\t.\t.\tXI\t";
+        vcf += list;
+        vcf += '\n';
+    }
+
+    VCF_scanner vcf_scanner;
+    VCF_reader vcf_reader(vcf, vcf.length());
+    VCF_header header;
+
+    std::stringstream dump;
+    REQUIRE(update_dump(dump, vcf_scanner, vcf_reader,
+            vcf_scanner.parse_header(&header)));
+
+    std::vector<int> values;
+    while (!vcf_scanner.at_eof()) {
+        REQUIRE(update_dump(dump, vcf_scanner, vcf_reader,
+                vcf_scanner.parse_genotype_format()));
+        REQUIRE(vcf_scanner.capture_ints("XI", &values));
+        if (dump_issues_and_clear_line(dump, vcf_scanner, vcf_reader,
+                    vcf_scanner.parse_genotype())) {
+            dump_list(dump, values);
+            REQUIRE(update_dump(dump, vcf_scanner, vcf_reader,
+                    vcf_scanner.clear_line()));
+        }
+        dump << '\n';
+    }
+
+    CHECK(dump.str() ==
+            "[0]\n[7]\n[1234567]\n[12345678]\n[123456789]\n[2147483647]\n"
+            "[-5]\n[5]\n[1]\n[]\n[1,-2147483648,3]\n[10,0,20]\n"
+            "[99,1234567,12345678,0]\n[1,2,3,4,5,6,7,8,9,10,11]\n"
+            "E:Invalid integer value of FORMAT key 'XI'\n"
+            "E:Invalid integer value of FORMAT key 'XI'\n"
+            "E:Invalid integer value of FORMAT key 'XI'\n"
+            "E:Invalid integer value of FORMAT key 'XI'\n"
+            "E:Invalid integer value of FORMAT key 'XI'\n"
+            "E:Invalid integer value of FORMAT key 'XI'\n"
+            "E:Invalid integer value of FORMAT key 'XI'\n"
+            "E:Invalid integer value of FORMAT key 'XI'\n");
+}
+
+TEST_CASE("Dosage rows")
+{
+    run_test_case_with_and_without_cr(R"(##fileformat=VCFv4.3
+##FORMAT=<ID=DS,Number=A,Type=Float,Description="Dosage">
+##FORMAT=<ID=GP,Number=G,Type=Float,Description="Probabilities">
+##FORMAT=<ID=FT,Number=1,Type=String,Description="Filter">
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO	FORMAT	S1	S2	S3
+1	100	.	C	G	.	.	.	GT:DS:GP	0|0:0.001:0.999,0.001,0	1|0:.:.	1|1
+1	200	.	C	G	.	.	.	GT:GP:DS	0|0:1,0,0:0	0|1:.5,.,.25:1.0	1|1:0,0.001,0.999:1.5e0
+1	300	.	C	G	.	.	.	DS	0.12345	3.9999	-1
+1	400	.	C	G	.	.	.	DS	0.5	4	0
+1	500	.	C	G	.	.	.	GT:GP	0|0:0.5,0.5	0|0:1,0,0	0|0:1,0,0
+1	600	.	C	G	.	.	.	GT	0|0	0|0	0|0
+1	700	.	C	G	.	.	.	GT:FT	0|0:PASS	0|0:q10	0|0:PASS
+1	800	.	C	G	.	.	.	GT:FT	0|0:PASS	0|0:q10	0|0:PASS)",
+            {
+                    {"^", ""},
+                    {"GF", "GF:OK"},
+                    {"GD31DS", "DS:[0.001,.,.]"},
+                    {";", ";"},
+                    {"GF", "GF:OK"},
+                    {"GX33GP",
+                            "GP:[16384,0,0,8192,65535,4096,0,16,16368]"},
+                    {";", ";"},
+                    {"GF", "GF:OK"},
+                    {"GD31DS", "DS:[0.12345,3.9999,-1]"},
+                    {";", ";"},
+                    {"GF", "GF:OK"},
+                    {"GX31DS", "E:Invalid dosage value"},
+                    {"GF", "GF:OK"},
+                    {"GD33GP", "E:Unexpected number of dosage values"},
+                    {"GF", "GF:OK"},
+                    {"GX31DS", "DS:[65535,65535,65535]"},
+                    {";", ";"},
+                    {"GF", "GF:OK"},
+                    {"GD31GT", "E:FORMAT key 'GT' is not of type Float"},
+                    {"GF", "GF:OK"},
+                    {"GX31FT", "E:FORMAT key 'FT' is not of type Float"},
+                    {".", ""},
+            });
+
+    run_test_case_with_and_without_cr(R"(##fileformat=VCFv4.3
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO	FORMAT	S1	S2	S3
+1	200	.	C	G	.	.	.	GT:GP:DS	0|0:1,0,0:0	0|1:.5,.,.25:1.0	1|1:0,0.001,0.999:1.5e0
+1	300	.	C	G	.	.	.	DS	0.12345	3.9999	2)",
+            {
+                    {"^", ""},
+                    {"GF", "GF:OK"},
+                    {"GD31DS", "DS:[0,1,1.5]"},
+                    {";", ";"},
+                    {"GF", "GF:OK"},
+                    {"GX31DS", "DS:[2023,65534,32768]"},
+                    {";", ";"},
+                    {".", ""},
+            });
+}
+
+TEST_CASE("Sparse genotype rows")
+{
+    run_test_case_with_and_without_cr(R"(##fileformat=VCFv4.3
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO	FORMAT	A	B	C	D	E	F	G
+1	100	.	C	G	.	.	.	GT	0/0	0/0	0|0	0|0	0/1	0/0	0/0
+1	200	.	C	G	.	.	.	GT	0/0	0|0	0/0	0/0	1|1	./.	0
+1	300	.	C	G	.	.	.	GT:DP	0/0:1	1:2	0/0	.	0/0/0	0/2:3
+1	400	.	C	G	.	.	.	DP	1	2	3	4	5	6	7
+1	500	.	C	G	.	.	.	GT	0/0	0/0	0/0	1/1
+1	600	.	C	G	.	.	.	GT	0/0	0/0	0/0	0/0	0/0	0/0	0/0
+1	700	.	C	G	.	.	.	GT	0/0	0/0	0/0	0/0	0/0	0/0	0/0	0/0
+1	800	.	C	G	.	.	.	GT	0/0	0/0	0/x)",
+            {
+                    {"^", ""},
+                    {"GF", "GF:OK"},
+                    {"GS", "GS:[4=0/1]"},
+                    {";", ";"},
+                    {"GF", "GF:OK"},
+                    {"GS", "GS:[4=1|1,5=./.]"},
+                    {";", ";"},
+                    {"GF", "GF:OK"},
+                    {"GS", "E:Ploidy exceeds that of the sparse genotype row"},
+                    {"GF", "GF:OK"},
+                    {"GS",
+                            "GS:[0=./.,1=./.,2=./.,3=./.,4=./.,5=./.,"
+                            "6=./.]"},
+                    {";", ";"},
+                    {"GF", "GF:OK"},
+                    {"GS", "GS:[3=1/1,4=./.,5=./.,6=./.]"},
+                    {";", ";"},
+                    {"GF", "GF:OK"},
+                    {"GS", "GS:[]"},
+                    {";", ";"},
+                    {"GF", "GF:OK"},
+                    {"GS",
+                            "E:The number of genotype fields exceeds "
+                            "the number of samples"},
+                    {"GF", "GF:OK"},
+                    {"GS", "E:Invalid character in GT value"},
+                    {".", ""},
+            });
+}
+
+TEST_CASE("Genotype predicates")
+{
+    // The invalid values after the decisive sample are never parsed.
+    run_test_case_with_and_without_cr(R"(##fileformat=VCFv4.3
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO	FORMAT	A	B	C	D	E	F	G
+1	100	.	C	G	.	.	.	GT	0/0	0/0	0/1	0/0	x	0/0	0/0
+1	200	.	C	G	.	.	.	GT	0/1	1/1	1|1	0/0	x	0/0	0/0
+1	300	.	C	G	.	.	.	GT	0/1	0/0	0/0	0/0	0/0	0/0	x
+1	400	.	C	G	.	.	.	GT:DP	./.:1	./1:2	1/2:3	1:4	0:5	0/0	0/0
+1	500	.	C	G	.	.	.	GT:DP	./.:1	./1:2	1/2:3	1:4	0:5	0/0	0/0
+1	600	.	C	G	.	.	.	GT:DP	./.:1	./1:2	1/2:3	1:4	0:5	0/0	0/0
+1	700	.	C	G	.	.	.	DP	1	2	3	4	5	6	7
+1	750	.	C	G	.	.	.	GT	0/0	0/0	0/0	0/0	0/0	0/0	0/1
+1	800	.	C	G	.	.	.	GT	0/0	0/0	0/0	0/1	0/0	0/0	0/x)",
+            {
+                    {"^", ""},
+                    {"GF", "GF:OK"},
+                    {"GEc1", "GE:true"},
+                    {";", ";"},
+                    {"GF", "GF:OK"},
+                    {"GEa2", "GE:true"},
+                    {";", ";"},
+                    {"GF", "GF:OK"},
+                    {"GEh3", "GE:false"},
+                    {";", ";"},
+                    {"GF", "GF:OK"},
+                    {"GEh2", "GE:false"},
+                    {";", ";"},
+                    {"GF", "GF:OK"},
+                    {"GEc3", "GE:true"},
+                    {";", ";"},
+                    {"GF", "GF:OK"},
+                    {"GEa1", "GE:true"},
+                    {";", ";"},
+                    {"GF", "GF:OK"},
+                    {"GEc1", "GE:false"},
+                    {";", ";"},
+                    // Decided by the last column; the next line is intact.
+                    {"GF", "GF:OK"},
+                    {"GEc1", "GE:true"},
+                    {";", ";"},
+                    {"L", "L:1@800"},
+                    {"GF", "GF:OK"},
+                    {"GEc2", "E:Invalid character in GT value"},
+                    {".", ""},
+            });
+}
+
+TEST_CASE("GT omitted from the end of a genotype field")
+{
+    run_test_case_with_and_without_cr(R"(##fileformat=VCFv4.0
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO	FORMAT	S1	S2	S3
+1	100	.	C	G	.	.	.	DP:GT	1:0|1	2	3:1/1)",
+            {
+                    {"^", ""},
+                    {"GF", "GF:OK"},
+                    {"GC", "GT:OK"},
+                    {"GT", "GT:[0,1]"},
+                    {"GT", "GT:[]"},
+                    {"GT", "GT:[1,1]"},
+                    {"GA", "GT:NO MORE"},
+                    {";", ";"},
+                    {".", ""},
+            });
+}
+
+static std::string dump_genotype_matrix(
+        const std::string& vcf, size_t chunk_size)
+{
+    VCF_reader vcf_reader(vcf, chunk_size);
+    VCF_scanner vcf_scanner;
+    VCF_header header;
+
+    std::stringstream dump;
+
+    auto parse = [&](VCF_parsing_event pe) {
+        if (pe == VCF_parsing_event::need_more_data) {
+            pe = vcf_reader.read_and_feed(vcf_scanner);
+        }
+        if (pe == VCF_parsing_event::error) {
+            dump << "E:" << vcf_scanner.get_error() << std::endl;
+            return false;
+        }
+        return true;
+    };
+
+    REQUIRE(parse(vcf_scanner.parse_header(&header)));
+
+    VCF_genotype_matrix matrix((unsigned) header.get_sample_ids().size());
+
+    std::string ref;
+    std::vector<std::string> alts;
+
+    while (!vcf_scanner.at_eof()) {
+        if (parse(vcf_scanner.parse_alleles(&ref, &alts)) &&
+                parse(vcf_scanner.parse_genotype_format()) &&
+                !parse(vcf_scanner.parse_gt_row(&matrix))) {
+            matrix.remove_last_variant();
+        }
+        parse(vcf_scanner.clear_line());
+    }
+
+    for (size_t v = 0; v < matrix.get_number_of_variants(); ++v) {
+        for (unsigned s = 0; s < matrix.get_number_of_samples(); ++s) {
+            dump << (s == 0 ? "" : " ");
+            for (unsigned i = 0; i < matrix.get_ploidy(); ++i) {
+                const int allele = matrix.get_allele(v, s, i);
+                if (allele == VCF_gt_missing) {
+                    dump << '.';
+                } else if (allele != VCF_gt_vector_end) {
+                    dump << allele;
+                }
+                if (i == 0) {
+                    dump << (matrix.is_phased(v, s) ? '|' : '/');
+                }
+            }
+        }
+        dump << std::endl;
+    }
+
+    return dump.str();
+}
+
+TEST_CASE("Genotype matrix")
+{
+    static const char vcf[] = R"(##fileformat=VCFv4.2
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO	FORMAT	A	B	C	D	E	F	G	H	I
+1	100	.	A	G	.	.	.	GT:DP	0/0:1	0|1	1/1:2	./.	0	.	1|.	0/1	1|0
+1	200	.	A	G,T	.	.	.	DP:GT	1:0/2	2:2|2	3	4:1/0	5:0	6:.	7:./1	8:2/2	9:0|0
+1	300	.	A	G	.	.	.	GT	0/0/1	0/0	0/0	0/0	0/0	0/0	0/0	0/0	0/0
+1	400	.	A	G	.	.	.	GT	0/2	0/0	0/0	0/0	0/0	0/0	0/0	0/0	0/0
+1	500	.	A	G	.	.	.	GT	0/	0/0	0/0	0/0	0/0	0/0	0/0	0/0	0/0
+1	600	.	A	G	.	.	.	DP	1	2	3	4	5	6	7	8	9
+1	700	.	A	G	.	.	.	GT	1/1	0/0	0/0	0/0	0/0	0/0	0/0	0/0	0/0	0/0
+1	800	.	A	G	.	.	.	GT	0/1	0/1
+)";
+
+    static const char expected[] =
+            "E:Ploidy exceeds that of the genotype matrix\n"
+            "E:Allele index exceeds the number of alleles\n"
+            "E:Invalid character in GT value\n"
+            "E:The number of genotype fields exceeds the number of samples\n"
+            "0/0 0|1 1/1 ./. 0/ ./ 1|. 0/1 1|0\n"
+            "0/2 2|2 ./. 1/0 0/ ./ ./1 2/2 0|0\n"
+            "./. ./. ./. ./. ./. ./. ./. ./. ./.\n"
+            "0/1 0/1 ./. ./. ./. ./. ./. ./. ./.\n";
+
+    const std::string vcf_str(vcf);
+
+    std::string vcf_with_cr;
+    for (char c : vcf_str) {
+        if (c == '\n') {
+            vcf_with_cr += '\r';
+        }
+        vcf_with_cr += c;
+    }
+
+    for (size_t chunk_size = 1; chunk_size <= vcf_str.length();
+            ++chunk_size) {
+        CHECK(dump_genotype_matrix(vcf_str, chunk_size) == expected);
+        CHECK(dump_genotype_matrix(vcf_with_cr, chunk_size) == expected);
+    }
+
+    VCF_reader vcf_reader(vcf_str, vcf_str.length());
+    VCF_scanner vcf_scanner;
+    VCF_header header;
+    std::stringstream dump;
+    REQUIRE(update_dump(dump, vcf_scanner, vcf_reader,
+            vcf_scanner.parse_header(&header)));
+    REQUIRE(update_dump(dump, vcf_scanner, vcf_reader,
+            vcf_scanner.parse_genotype_format()));
+
+    // The matrix is too small for the nine samples of the file.
+    VCF_genotype_matrix small_matrix(2);
+    CHECK(vcf_scanner.parse_gt_row(&small_matrix) ==
+            VCF_parsing_event::error);
+    CHECK(vcf_scanner.get_error() ==
+            "The genotype matrix has fewer samples than the output");
+    CHECK(small_matrix.get_number_of_variants() == 0);
+}
+
+static std::string dump_allele_counts(const std::string& vcf, size_t chunk_size)
+{
+    VCF_reader vcf_reader(vcf, chunk_size);
+    VCF_scanner vcf_scanner;
+    VCF_header header;
+
+    std::stringstream dump;
+
+    auto parse = [&](VCF_parsing_event pe) {
+        if (pe == VCF_parsing_event::need_more_data) {
+            pe = vcf_reader.read_and_feed(vcf_scanner);
+        }
+        if (pe == VCF_parsing_event::error) {
+            dump << "E:" << vcf_scanner.get_error() << std::endl;
+            return false;
+        }
+        return true;
+    };
+
+    REQUIRE(parse(vcf_scanner.parse_header(&header)));
+
+    std::string ref;
+    std::vector<std::string> alts;
+    VCF_allele_counts counts;
+
+    while (!vcf_scanner.at_eof()) {
+        if (parse(vcf_scanner.parse_alleles(&ref, &alts)) &&
+                parse(vcf_scanner.parse_genotype_format()) &&
+                parse(vcf_scanner.count_alleles(&counts))) {
+            dump << "AC=";
+            dump_list(dump, counts.allele_counts);
+            dump << ";AN=" << counts.number_of_called_alleles
+                 << ";HOM_REF=" << counts.hom_ref << ";HET=" << counts.het
+                 << ";HOM_ALT=" << counts.hom_alt
+                 << ";MISSING=" << counts.missing << std::endl;
+        }
+        parse(vcf_scanner.clear_line());
+    }
+
+    return dump.str();
+}
+
+TEST_CASE("Allele counting")
+{
+    static const char vcf[] = R"(##fileformat=VCFv4.2
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO	FORMAT	A	B	C	D	E	F
+1	100	.	A	G	.	.	.	GT:DP	0/0:1	0|1	1/1:2	./.	0	1|.
+1	200	.	A	G,T	.	.	.	DP:GT	1:0/2	2:2|2	3	4:1/0	5:1	6:0/0/0
+1	300	.	A	G	.	.	.	DP	1	2	3	4	5	6
+1	400	.	A	G	.	.	.	GT	0/0	0/0	0/0	0/0	0/0	0/3
+)";
+
+    static const char expected[] =
+            "AC=[4,4];AN=8;HOM_REF=2;HET=1;HOM_ALT=1;MISSING=2\n"
+            "AC=[5,2,3];AN=10;HOM_REF=1;HET=2;HOM_ALT=2;MISSING=1\n"
+            "AC=[0,0];AN=0;HOM_REF=0;HET=0;HOM_ALT=0;MISSING=6\n"
+            "E:Allele index exceeds the number of alleles\n";
+
+    const std::string vcf_str(vcf);
+
+    for (size_t chunk_size = 1; chunk_size <= vcf_str.length();
+            ++chunk_size) {
+        CHECK(dump_allele_counts(vcf_str, chunk_size) == expected);
+    }
+}
+
+TEST_CASE("Captures apply to the current data line")
+{
+    std::string vcf = "##fileformat=VCFv4.2\n"
+                      "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\t"
+                      "FORMAT\tS1\tS2\n"
+                      "1\t1\t.\tA\tG\t.\t.\t.\tGT:DP\t0/1:5\t1/1:6\n"
+                      "1\t2\t.\tA\tG\t.\t.\t.\tGT:DP\t1/1:7\t0/0:8\n";
+    // More distinct FORMAT fields than the parser keeps plans for.
+    for (int i = 0; i < 17; ++i) {
+        vcf += "1\t3\t.\tA\tG\t.\t.\t.\tK" + std::to_string(i) +
+                "\t1\t2\n";
+    }
+    vcf += "1\t4\t.\tA\tG\t.\t.\t.\tGT:DP\t0/0:3\t0/1:4\n";
+
+    for (size_t chunk_size = 1; chunk_size <= vcf.length(); ++chunk_size) {
+        VCF_reader vcf_reader(vcf, chunk_size);
+        VCF_scanner vcf_scanner;
+        VCF_header header;
+
+        std::stringstream dump;
+        REQUIRE(update_dump(dump, vcf_scanner, vcf_reader,
+                vcf_scanner.parse_header(&header)));
+
+        auto parse_genotype = [&] {
+            REQUIRE(update_dump(dump, vcf_scanner, vcf_reader,
+                    vcf_scanner.parse_genotype()));
+        };
+        auto parse_format = [&] {
+            REQUIRE(update_dump(dump, vcf_scanner, vcf_reader,
+                    vcf_scanner.parse_genotype_format()));
+        };
+        auto clear_line = [&] {
+            REQUIRE(update_dump(
+                    dump, vcf_scanner, vcf_reader, vcf_scanner.clear_line()));
+        };
+
+        int dp = 0;
+        // No FORMAT field has been parsed yet.
+        CHECK(!vcf_scanner.capture_gt());
+        CHECK(!vcf_scanner.capture_int("DP", &dp));
+
+        parse_format();
+        REQUIRE(vcf_scanner.capture_int("DP", &dp));
+        parse_genotype();
+        dump << dp << ';';
+        // The second sample is parsed without the capture.
+        vcf_scanner.clear_genotype_captures();
+        parse_genotype();
+        dump << dp << ';';
+        clear_line();
+
+        // The captures of the previous line are gone.
+        CHECK(!vcf_scanner.capture_int("DP", &dp));
+        parse_format();
+        parse_genotype();
+        dump << dp << ';';
+        REQUIRE(vcf_scanner.capture_int("DP", &dp));
+        parse_genotype();
+        dump << dp << ';';
+        clear_line();
+
+        for (int i = 0; i < 17; ++i) {
+            parse_format();
+            CHECK(!vcf_scanner.capture_gt());
+            CHECK(!vcf_scanner.capture_int("DP", &dp));
+            parse_genotype();
+            clear_line();
+        }
+
+        // The plan for GT:DP has been evicted and is compiled again.
+        parse_format();
+        while (vcf_scanner.genotype_available()) {
+            int sample_dp = 0;
+            REQUIRE(vcf_scanner.capture_gt());
+            REQUIRE(vcf_scanner.capture_int("DP", &sample_dp));
+            parse_genotype();
+            dump_list(dump, vcf_scanner.get_gt());
+            dump << sample_dp << ';';
+            vcf_scanner.clear_genotype_captures();
+        }
+        clear_line();
+
+        CHECK(dump.str() == "5;5;5;8;[0,0]3;[0,1]4;");
+    }
+}
+
+static std::string dump_selected_samples(
+        const std::string& vcf, size_t chunk_size, bool use_gt_row)
+{
+    VCF_reader vcf_reader(vcf, chunk_size);
+    VCF_scanner vcf_scanner;
+    VCF_header header;
+
+    std::stringstream dump;
+
+    auto parse = [&](VCF_parsing_event pe) {
+        if (pe == VCF_parsing_event::need_more_data) {
+            pe = vcf_reader.read_and_feed(vcf_scanner);
+        }
+        if (pe == VCF_parsing_event::error) {
+            dump << "E:" << vcf_scanner.get_error() << std::endl;
+            return false;
+        }
+        return true;
+    };
+
+    REQUIRE(parse(vcf_scanner.parse_header(&header)));
+
+    CHECK(!vcf_scanner.select_samples(std::vector<std::string>{"A", "X"}));
+    CHECK(!vcf_scanner.select_samples(std::vector<unsigned>{1, 12}));
+    CHECK(vcf_scanner.get_selected_samples().empty());
+
+    REQUIRE(vcf_scanner.select_samples(std::vector<unsigned>{9, 1, 9}));
+    CHECK(vcf_scanner.get_selected_samples() == std::vector<unsigned>({1, 9}));
+
+    // An empty selection is rejected rather than selecting all samples.
+    CHECK(!vcf_scanner.select_samples(std::vector<std::string>()));
+    CHECK(!vcf_scanner.select_samples(std::vector<unsigned>()));
+    CHECK(vcf_scanner.get_selected_samples() == std::vector<unsigned>({1, 9}));
+
+    REQUIRE(vcf_scanner.select_samples(
+            std::vector<std::string>{"J", "B", "I", "B"}));
+    CHECK(vcf_scanner.get_selected_samples() ==
+            std::vector<unsigned>({1, 8, 9}));
+
+    VCF_genotype_matrix matrix(3);
+
+    while (!vcf_scanner.at_eof()) {
+        if (!parse(vcf_scanner.parse_genotype_format())) {
+            parse(vcf_scanner.clear_line());
+            continue;
+        }
+        if (use_gt_row) {
+            matrix.clear();
+            if (parse(vcf_scanner.parse_gt_row(&matrix))) {
+                for (unsigned s = 0; s < 3; ++s) {
+                    dump << '[' << (int) matrix.get_allele(0, s, 0) << ','
+                         << (int) matrix.get_allele(0, s, 1) << ']';
+                }
+            }
+        } else {
+            vcf_scanner.capture_gt();
+            while (vcf_scanner.genotype_available()) {
+                if (!parse(vcf_scanner.parse_genotype())) {
+                    break;
+                }
+                dump_list(dump, vcf_scanner.get_gt());
+            }
+        }
+        dump << std::endl;
+        parse(vcf_scanner.clear_line());
+    }
+
+    return dump.str();
+}
+
+TEST_CASE("Sample selection")
+{
+    static const char vcf[] = R"(##fileformat=VCFv4.2
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO	FORMAT	A	B	C	D	E	F	G	H	I	J	K	L
+1	100	.	A	G	.	.	.	GT:DP	0/0:1	0/1:2	0/0	1/1:4	0/0	0/0	0/0:7	0/0	1|0	1/1	0/0	0/0
+1	200	.	A	G	.	.	.	DP:GT	1:0/0	2:1/1	3:0/0	4:0/0	5:0/0
+1	300	.	A	G	.	.	.	GT	0/0	0/0	0/0	0/0	0/0	0/0	0/0	0/0	./1	0/0	0/0	0/0	0/0
+1	400	.	A	G	.	.	.	GT	./.	0/0	./.	./.	./.	./.	./.	./.	0/x	./.	./.	./.
+)";
+
+    static const char expected_genotypes[] = "[0,1][1,0][1,1]\n"
+                                             "[1,1][]\n"
+                                             "[0,0][-1,1][0,0]\n"
+                                             "[0,0]E:Invalid character "
+                                             "in GT value\n\n";
+
+    static const char expected_gt_rows[] =
+            "[0,1][1,0][1,1]\n"
+            "[1,1][-1,-1][-1,-1]\n"
+            "[0,0][-1,1][0,0]\n"
+            "E:Invalid character in GT value\n\n";
+
+    const std::string vcf_str(vcf);
+
+    for (size_t chunk_size = 1; chunk_size <= vcf_str.length();
+            ++chunk_size) {
+        CHECK(dump_selected_samples(vcf_str, chunk_size, false) ==
+                expected_genotypes);
+        CHECK(dump_selected_samples(vcf_str, chunk_size, true) ==
+                expected_gt_rows);
+    }
+}
+
+static std::string dump_indexed_genotypes(
+        const std::string& vcf, size_t chunk_size)
+{
+    VCF_reader vcf_reader(vcf, chunk_size);
+    VCF_scanner vcf_scanner;
+    VCF_header header;
+
+    std::stringstream dump;
+
+    auto parse = [&](VCF_parsing_event pe) {
+        if (pe == VCF_parsing_event::need_more_data) {
+            pe = vcf_reader.read_and_feed(vcf_scanner);
+        }
+        if (pe == VCF_parsing_event::error) {
+            dump << "E:" << vcf_scanner.get_error() << ';';
+            return false;
+        }
+        return true;
+    };
+
+    REQUIRE(parse(vcf_scanner.parse_header(&header)));
+
+    std::string ref;
+    std::vector<std::string> alts;
+    int dp;
+
+    while (!vcf_scanner.at_eof()) {
+        if (parse(vcf_scanner.parse_alleles(&ref, &alts)) &&
+                parse(vcf_scanner.parse_genotype_format())) {
+            vcf_scanner.capture_gt();
+            vcf_scanner.capture_int("DP", &dp);
+            if (parse(vcf_scanner.index_genotypes())) {
+                dump << vcf_scanner.get_number_of_indexed_genotypes() << ':';
+                // In reverse order and twice.
+                for (unsigned sample : {2, 1, 0, 2}) {
+                    if (parse(vcf_scanner.parse_genotype_of(sample))) {
+                        dump_list(dump, vcf_scanner.get_gt());
+                        dump << dp << ';';
+                    }
+                }
+            }
+        }
+        dump << std::endl;
+        parse(vcf_scanner.clear_line());
+    }
+
+    return dump.str();
+}
+
+TEST_CASE("Random access to genotype columns")
+{
+    static const char vcf[] = R"(##fileformat=VCFv4.2
+##FORMAT=<ID=DP,Number=1,Type=Integer,Description="Read depth">
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO	FORMAT	A	B	C
+1	100	.	A	G	.	.	.	GT:DP	0/0:10	0|1:200	1/1:3000
+1	200	.	A	G,T	.	.	.	DP:GT	1:0/2	2
+1	300	.	A	G	.	.	.	GT	0/0	0/0	0/0	0/0
+1	400	.	A	G	.	.	.	GT:DP	0/1:x	./.:1:2	0/1/2
+1	500	.	A	G	.	.	.	GT	1/0	0/1	1/1
+)";
+
+    static const char expected[] =
+            "3:[1,1]3000;[0,1]200;[0,0]10;[1,1]3000;\n"
+            "2:[]-2147483648;[]2;[0,2]1;[]-2147483648;\n"
+            "E:The number of genotype fields exceeds the number of samples;\n"
+            "3:E:Allele index exceeds the number of alleles;"
+            "E:Too many genotype info fields;"
+            "E:Invalid integer value of FORMAT key 'DP';"
+            "E:Allele index exceeds the number of alleles;\n"
+            "3:[1,1]-2147483648;[0,1]-2147483648;[1,0]-2147483648;"
+            "[1,1]-2147483648;\n";
+
+    const std::string vcf_str(vcf);
+
+    std::string vcf_with_cr;
+    for (char c : vcf_str) {
+        if (c == '\n') {
+            vcf_with_cr += '\r';
+        }
+        vcf_with_cr += c;
+    }
+
+    for (size_t chunk_size = 1; chunk_size <= vcf_str.length();
+            ++chunk_size) {
+        CHECK(dump_indexed_genotypes(vcf_str, chunk_size) == expected);
+        CHECK(dump_indexed_genotypes(vcf_with_cr, chunk_size) == expected);
+    }
+}
@@ -0,0 +1,229 @@
+#include "test_plan.hh"
+
+#include <cmath>
+
+static const char info_test_vcf[] = R"(##fileformat=VCFv4.2
+##INFO=<ID=NS,Number=1,Type=Integer,Description="Number of Samples">
+##INFO=<ID=AF,Number=A,Type=Float,Description="Allele Frequency">
+##INFO=<ID=AD,Number=R,Type=Integer,Description="Allelic depths">
+##INFO=<ID=DB,Number=0,Type=Flag,Description="dbSNP membership, build 129">
+##INFO=<ID=AA,Number=1,Type=String,Description="Ancestral Allele">
+##INFO=<ID=CSQ,Number=.,Type=String,Description="Consequence">
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO
+1	100	.	A	G,T	.	.	NS=3;AF=0.5,.;AD=1,2,3;DB;AA=G;CSQ=a,b
+1	200	.	A	G	.	.	.
+1	300	.	A	G	.	.	XX=1;NS=.;AF=0.25
+1	400	.	A	G,T	.	.	AF=0.5
+1	500	.	A	G	.	.	NS=1x)";
+
+TEST_CASE("INFO key definitions")
+{
+    VCF_reader vcf_reader(info_test_vcf, 1);
+    VCF_scanner vcf_scanner;
+    VCF_header header;
+
+    std::stringstream dump;
+    REQUIRE(update_dump(dump, vcf_scanner, vcf_reader,
+            vcf_scanner.parse_header(&header)));
+
+    const auto& definitions = header.get_info_definitions();
+    REQUIRE(definitions.size() == 6);
+
+    const VCF_key_definition& af = definitions.at("AF");
+    CHECK(af.data_type == VCF_key_definition::float_type);
+    CHECK(af.number_of_values == VCF_key_definition::one_per_alt);
+    CHECK(af.description == "Allele Frequency");
+
+    const VCF_key_definition& ns = definitions.at("NS");
+    CHECK(ns.data_type == VCF_key_definition::integer_type);
+    CHECK(ns.number_of_values == VCF_key_definition::exact_number);
+    CHECK(ns.number == 1);
+
+    const VCF_key_definition& db = definitions.at("DB");
+    CHECK(db.data_type == VCF_key_definition::flag_type);
+    CHECK(db.number == 0);
+    CHECK(db.description == "dbSNP membership, build 129");
+
+    CHECK(definitions.at("AD").number_of_values ==
+            VCF_key_definition::one_per_allele);
+    CHECK(definitions.at("CSQ").number_of_values ==
+            VCF_key_definition::unbound);
+
+    CHECK(header.get_format_definitions().empty());
+}
+
+static std::string dump_info_captures(
+        const std::string& vcf, size_t chunk_size, bool selective = false)
+{
+    VCF_reader vcf_reader(vcf, chunk_size);
+    VCF_scanner vcf_scanner;
+    VCF_header header;
+
+    std::stringstream dump;
+
+    auto parse = [&](VCF_parsing_event pe) {
+        if (pe == VCF_parsing_event::need_more_data) {
+            pe = vcf_reader.read_and_feed(vcf_scanner);
+        }
+        if (pe == VCF_parsing_event::error) {
+            dump << "E:" << vcf_scanner.get_error() << std::endl;
+            return false;
+        }
+        return true;
+    };
+
+    REQUIRE(parse(vcf_scanner.parse_header(&header)));
+
+    int ns;
+    std::vector<float> af;
+    std::vector<int> ad;
+    bool db;
+    std::string aa;
+    std::vector<std::string> csq;
+
+    CHECK(vcf_scanner.capture_info_int("NS", &ns));
+    CHECK(vcf_scanner.capture_info_floats("AF", &af));
+    CHECK(vcf_scanner.capture_info_ints("AD", &ad));
+    CHECK(vcf_scanner.capture_info_flag("DB", &db));
+    CHECK(vcf_scanner.capture_info_string("AA", &aa));
+    CHECK(vcf_scanner.capture_info_strings("CSQ", &csq));
+
+    // Undeclared keys, type and number mismatches.
+    int xx;
+    float af_scalar;
+    std::vector<int> aa_ints;
+    bool ns_flag;
+    CHECK(!vcf_scanner.capture_info_int("XX", &xx));
+    CHECK(!vcf_scanner.capture_info_float("AF", &af_scalar));
+    CHECK(!vcf_scanner.capture_info_ints("AA", &aa_ints));
+    CHECK(!vcf_scanner.capture_info_flag("NS", &ns_flag));
+
+    std::string ref;
+    std::vector<std::string> alts;
+
+    while (!vcf_scanner.at_eof()) {
+        if (parse(vcf_scanner.parse_alleles(&ref, &alts)) &&
+                parse(selective ? vcf_scanner.parse_captured_info() :
+                                  vcf_scanner.parse_info())) {
+            if (selective && !vcf_scanner.get_info().empty()) {
+                dump << "INFO is not empty" << std::endl;
+            }
+            dump << "NS=";
+            if (ns == VCF_missing_int) {
+                dump << '.';
+            } else {
+                dump << ns;
+            }
+            dump << ";AF=";
+            for (float value : af) {
+                if (std::isnan(value)) {
+                    dump << ".,";
+                } else {
+                    dump << value << ',';
+                }
+            }
+            dump << ";AD=";
+            dump_list(dump, ad);
+            dump << ";DB=" << db << ";AA=" << aa << ";CSQ=";
+            dump_list(dump, csq);
+            dump << std::endl;
+        }
+        parse(vcf_scanner.clear_line());
+    }
+
+    return dump.str();
+}
+
+TEST_CASE("Typed INFO capture")
+{
+    static const char expected[] =
+            "NS=3;AF=0.5,.,;AD=[1,2,3];DB=1;AA=G;CSQ=[a,b]\n"
+            "NS=.;AF=;AD=[];DB=0;AA=;CSQ=[]\n"
+            "NS=.;AF=0.25,;AD=[];DB=0;AA=;CSQ=[]\n"
+            "E:Unexpected number of values of INFO key 'AF'\n"
+            "E:Invalid integer value of INFO key 'NS'\n";
+
+    const std::string vcf(info_test_vcf);
+
+    for (size_t chunk_size = 1; chunk_size <= vcf.length(); ++chunk_size) {
+        CHECK(dump_info_captures(vcf, chunk_size) == expected);
+    }
+}
+
+TEST_CASE("The last INFO key on the line")
+{
+    run_test_case_with_and_without_cr(R"(##fileformat=VCFv4.0
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO
+1	100	.	C	G	.	.	NS=3;DB
+1	200	.	C	G	.	.	DP=14)",
+            {
+                    {"^", ""},
+                    {"I", "I:[NS=3,DB]"},
+                    {";", ";"},
+                    {"I", "I:[DP=14]"},
+                    {";", ";"},
+                    {".", ""},
+            });
+}
+
+TEST_CASE("Selective INFO capture")
+{
+    static const char expected[] =
+            "NS=3;AF=0.5,.,;AD=[1,2,3];DB=1;AA=G;CSQ=[a,b]\n"
+            "NS=.;AF=;AD=[];DB=0;AA=;CSQ=[]\n"
+            "NS=.;AF=0.25,;AD=[];DB=0;AA=;CSQ=[]\n"
+            "E:Unexpected number of values of INFO key 'AF'\n"
+            "E:Invalid integer value of INFO key 'NS'\n"
+            "NS=2;AF=;AD=[];DB=1;AA=;CSQ=[]\n"
+            "NS=.;AF=;AD=[];DB=1;AA=C;CSQ=[]\n";
+
+    std::string vcf(info_test_vcf);
+    vcf += "\n1\t600\t.\tA\tG\t.\t.\tXX=a,b;DB=;NS=2\tGT\t0/1";
+    vcf += "\n1\t700\t.\tA\tG\t.\t.\tAAA=T;AA=C;X;DB\n";
+
+    std::string vcf_with_cr;
+    for (char c : vcf) {
+        if (c == '\n') {
+            vcf_with_cr += '\r';
+        }
+        vcf_with_cr += c;
+    }
+
+    for (size_t chunk_size = 1; chunk_size <= vcf.length(); ++chunk_size) {
+        CHECK(dump_info_captures(vcf, chunk_size, true) == expected);
+        CHECK(dump_info_captures(vcf_with_cr, chunk_size, true) == expected);
+    }
+}
+
+TEST_CASE("FILTER and INFO flag IDs")
+{
+    run_test_case_with_and_without_cr(R"(##fileformat=VCFv4.0
+##FILTER=<ID=q10,Description="Quality below 10">
+##FILTER=<ID=s50,Description="Less than 50% of samples have data">
+##INFO=<ID=H2,Number=0,Type=Flag,Description="HapMap2 membership">
+##INFO=<ID=DB,Number=0,Type=Flag,Description="dbSNP membership">
+##INFO=<ID=NS,Number=1,Type=Integer,Description="Number of Samples">
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO
+1	100	.	C	G	.	PASS	NS=3;H2
+1	200	.	C	G	.	s50;lc;q10	DB;X;NS=2
+1	300	.	C	G	.	.	.
+1	400	.	C	G	.	lc;q10	NS=1;DB
+1	500	.	C	G	.	PASS)",
+            {
+                    {"^", ""},
+                    {"P", "P:[0=PASS]"},
+                    {"J", "J:[0=H2]"},
+                    {";", ";"},
+                    {"P", "P:[1=q10,2=s50,3=lc]"},
+                    {"JC", "J:[1=DB,2=X]"},
+                    {";", ";"},
+                    {"P", "P:[]"},
+                    {"J", "J:[]"},
+                    {";", ";"},
+                    {"P", "P:[1=q10,3=lc]"},
+                    {"JC", "J:[1=DB]"},
+                    {";", ";"},
+                    {"P", "E:Missing mandatory VCF field \"INFO\""},
+                    {".", ""},
+            });
+}
@@ -0,0 +1,148 @@
+#include <vcf_scanner/vcf_plink.hh>
+
+#include "test_plan.hh"
+
+#include <fstream>
+
+static std::string read_file(const std::string& pathname)
+{
+    std::ifstream file(pathname, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+static const char plink_test_vcf[] = R"(##fileformat=VCFv4.2
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO	FORMAT	S1	S2	S3	S4	S5
+1	100	rs1	A	G	.	.	.	GT	0/0	0|1	1/1	./.	1
+1	200	.	C	T,G	.	.	.	GT:DP	0/2:1	1/2	2/2	0/1	./1
+2	300	rs2;rs3	G	.	.	.	.	DP	1	2	3	4	5)";
+
+static std::string convert_to_plink(const std::string& prefix,
+        VCF_multiallelic_policy policy,
+        const std::vector<std::string>& sample_ids = {})
+{
+    VCF_reader vcf_reader(plink_test_vcf, 7);
+    VCF_scanner vcf_scanner;
+    VCF_header header;
+
+    VCF_parsing_event pe = vcf_scanner.parse_header(&header);
+    while (pe == VCF_parsing_event::need_more_data) {
+        pe = vcf_reader.read_and_feed(vcf_scanner);
+    }
+    REQUIRE(pe == VCF_parsing_event::ok);
+
+    if (!sample_ids.empty()) {
+        REQUIRE(vcf_scanner.select_samples(sample_ids));
+    }
+
+    VCF_plink_writer plink_writer(policy);
+    REQUIRE(plink_writer.open(
+            prefix, header, vcf_scanner.get_selected_samples()));
+    if (!plink_writer.convert(vcf_scanner, vcf_reader)) {
+        return plink_writer.get_error();
+    }
+    REQUIRE(plink_writer.close());
+    CHECK(plink_writer.get_number_of_variants() == 3);
+
+    return std::string();
+}
+
+TEST_CASE("PLINK fileset")
+{
+    REQUIRE(convert_to_plink("plink_as_missing",
+                    VCF_multiallelic_policy::as_missing) == "");
+
+    CHECK(read_file("plink_as_missing.fam") ==
+            "S1\tS1\t0\t0\t0\t-9\n"
+            "S2\tS2\t0\t0\t0\t-9\n"
+            "S3\tS3\t0\t0\t0\t-9\n"
+            "S4\tS4\t0\t0\t0\t-9\n"
+            "S5\tS5\t0\t0\t0\t-9\n");
+
+    CHECK(read_file("plink_as_missing.bim") ==
+            "1\trs1\t0\t100\tG\tA\n"
+            "1\t.\t0\t200\tT\tC\n"
+            "2\trs2;rs3\t0\t300\t0\tG\n");
+
+    // Genotype codes: 0 - hom ALT, 1 - missing, 2 - het, 3 - hom REF.
+    // Four samples per byte, starting from the low-order bits.
+    static const unsigned char expected_bed[] = {0x6C, 0x1B, 0x01,
+            // 0/0 0|1 1/1 ./.  1
+            3 | 2 << 2 | 0 << 4 | 1 << 6, 0,
+            // 0/2 1/2 2/2 0/1  ./1
+            1 | 1 << 2 | 1 << 4 | 2 << 6, 1,
+            // No GT
+            0x55, 1};
+    CHECK(read_file("plink_as_missing.bed") ==
+            std::string((const char*) expected_bed, sizeof(expected_bed)));
+
+    REQUIRE(convert_to_plink("plink_collapse_alts",
+                    VCF_multiallelic_policy::collapse_alts) == "");
+
+    CHECK(read_file("plink_collapse_alts.bim") ==
+            "1\trs1\t0\t100\tG\tA\n"
+            "1\t.\t0\t200\tT,G\tC\n"
+            "2\trs2;rs3\t0\t300\t0\tG\n");
+
+    const std::string bed = read_file("plink_collapse_alts.bed");
+    REQUIRE(bed.length() == sizeof(expected_bed));
+    // 0/2 1/2 2/2 0/1  ./1
+    CHECK((unsigned char) bed[5] == (2 | 0 << 2 | 0 << 4 | 2 << 6));
+    CHECK(bed[6] == 1);
+
+    CHECK(convert_to_plink("plink_error", VCF_multiallelic_policy::error) ==
+            "Line 4: Genotype refers to a second ALT allele");
+}
+
+TEST_CASE("PLINK fileset for selected samples")
+{
+    REQUIRE(convert_to_plink("plink_selected",
+                    VCF_multiallelic_policy::as_missing, {"S5", "S2"}) == "");
+
+    CHECK(read_file("plink_selected.fam") ==
+            "S2\tS2\t0\t0\t0\t-9\n"
+            "S5\tS5\t0\t0\t0\t-9\n");
+
+    static const unsigned char expected_bed[] = {0x6C, 0x1B, 0x01,
+            // 0|1  1
+            2 | 0 << 2,
+            // 1/2  ./1
+            1 | 1 << 2,
+            // No GT
+            0x05};
+    CHECK(read_file("plink_selected.bed") ==
+            std::string((const char*) expected_bed, sizeof(expected_bed)));
+
+    // The scanner outputs more samples than the .fam file lists.
+    VCF_reader vcf_reader(plink_test_vcf, sizeof(plink_test_vcf));
+    VCF_scanner vcf_scanner;
+    VCF_header header;
+    REQUIRE(vcf_scanner.parse_header(&header) ==
+            VCF_parsing_event::need_more_data);
+    REQUIRE(vcf_reader.read_and_feed(vcf_scanner) == VCF_parsing_event::ok);
+
+    VCF_plink_writer plink_writer;
+    REQUIRE(plink_writer.open("plink_mismatch", header, {4}));
+    CHECK(!plink_writer.convert(vcf_scanner, vcf_reader));
+    CHECK(plink_writer.get_error() ==
+            "The samples selected in the scanner differ "
+            "from the samples of the .fam file");
+}
+
+TEST_CASE("Packed genotype row")
+{
+    run_test_case_with_and_without_cr(R"(##fileformat=VCFv4.0
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO	FORMAT	S1	S2	S3	S4	S5
+1	100	.	C	G	.	.	.	DP:GT	1:0/0	2:1|0	3:1/1	4:./0	5
+1	200	.	C	G	.	.	.	GT	0/0	1	0/1/1	0/0	0/x)",
+            {
+                    {"^", ""},
+                    {"GF", "GF:OK"},
+                    {"GP5", "GP:[3,2,0,1,1]"},
+                    {";", ";"},
+                    {"GF", "GF:OK"},
+                    {"GP5", "E:Invalid character in GT value"},
+                    {".", ""},
+            });
+}
@@ -0,0 +1,193 @@
+#include "test_plan.hh"
+
+TEST_CASE("Lazy records")
+{
+    run_test_case_with_and_without_cr(R"(##fileformat=VCFv4.0
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO	FORMAT	S1	S2
+1	1000	rs1;rs2	C	G,T	50.5	PASS	DP=10;AF=0.5,0.1;DB	GT	0/2	1|1
+2	200	.	A	.	.	.	.	GT	0/1	0
+X	x	.	A	.,G	.	q10;.	.
+Y	1	.	A	G	.
+Z	4294967296	.	AC	A	1e3	.	;NS=2;	GT:DP	./.:1)",
+            {
+                    {"^", ""},
+                    {"R",
+                            "I:[DP=10,AF=0.5,0.1,DB];L:1@1000;"
+                            "ID:[rs1,rs2];R:C;A:[G,T];Q:50.5;F:[PASS]"},
+                    {"GF", "GF:OK"},
+                    {"GC", "GT:OK"},
+                    {"GT", "GT:[0,2]"},
+                    {"GT", "GT:[1,1]"},
+                    {";", ";"},
+                    {"R", "I:[];L:2@200;ID:[];R:A;A:[];Q:;F:[]"},
+                    {"GF", "GF:OK"},
+                    {"GC", "GT:OK"},
+                    // There are no ALT alleles.
+                    {"GT", "E:Allele index exceeds the number of alleles"},
+                    {"R", "I:[];L:X@?;ID:[];R:A;A:[G];Q:;F:[q10]"},
+                    {";", ";"},
+                    {"R", "E:Missing mandatory VCF field \"FILTER\""},
+                    {"R",
+                            "I:[NS=2];L:Z@?;ID:[];R:AC;A:[A];Q:1e3;F:[]"},
+                    {"GF", "GF:OK"},
+                    {"GC", "GT:OK"},
+                    {"GT", "GT:[-1,-1]"},
+                    {";", ";"},
+                    {".", ""},
+            });
+}
+
+TEST_CASE("Record batches")
+{
+    run_test_case_with_and_without_cr(R"(##fileformat=VCFv4.0
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO	FORMAT	S1
+1	100	rs1	C	G,T	50.5	PASS	DP=10	GT	0/1
+1	200	.	A	.	.	.	.
+2	300	rs2;rs3	AC	A	1e3	q10;s50	NS=2	GT	1|1
+1	x	.	A	G	.	.	.
+1	400	.	A	G	.	q10	.	GT	0/0
+X	500	.	G	C
+X	600	.	G	C	7	PASS;q10	AF=0.5)",
+            {
+                    {"^", ""},
+                    {"B0", "B:[]"},
+                    {"B2",
+                            "B:[1@100|rs1|C|G,T|50.5|PASS|DP=10 "
+                            "1@200|.|A|.|.||.]"},
+                    {"B9",
+                            "E:Invalid integer in the POS column"
+                            "B:[2@300|rs2;rs3|AC|A|1000|q10;s50|NS=2]"},
+                    {"L", "L:1@400"},
+                    {";", ";"},
+                    {"B9",
+                            "E:Missing mandatory VCF field \"QUAL\"B:[]"},
+                    {"B9", "B:[X@600|.|G|C|7|PASS;q10|AF=0.5]"},
+                    {".", ""},
+            });
+}
+
+TEST_CASE("FILTER bitmap of a record batch")
+{
+    std::string vcf = "##fileformat=VCFv4.0\n"
+                      "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\n"
+                      "1\t1\t.\tA\tG\t.\tf1\t.\n"
+                      "1\t2\t.\tA\tG\t.\t";
+    for (int i = 2; i <= 70; ++i) {
+        vcf += 'f' + std::to_string(i) + ';';
+    }
+    vcf += "f1\t.\n";
+
+    VCF_scanner vcf_scanner;
+    VCF_reader vcf_reader(vcf, vcf.length());
+    VCF_header header;
+    VCF_record_batch batch;
+
+    std::stringstream dump;
+    REQUIRE(update_dump(dump, vcf_scanner, vcf_reader,
+            vcf_scanner.parse_header(&header)));
+    REQUIRE(update_dump(dump, vcf_scanner, vcf_reader,
+            vcf_scanner.parse_batch(&batch, 10)));
+    CHECK(vcf_scanner.at_eof());
+
+    REQUIRE(batch.get_number_of_records() == 2);
+    CHECK(batch.get_filter_row_size() == 2);
+    CHECK(vcf_scanner.get_filter_names().size() == 71);
+
+    const unsigned f1 = vcf_scanner.find_filter_id("f1");
+    const unsigned f70 = vcf_scanner.find_filter_id("f70");
+    CHECK(f1 == 1);
+    CHECK(f70 == 70);
+    CHECK(vcf_scanner.find_filter_id("f71") == UINT_MAX);
+
+    CHECK(batch.has_filter(0, f1));
+    CHECK_FALSE(batch.has_filter(0, f70));
+    CHECK_FALSE(batch.has_filter(0, VCF_pass_filter_id));
+    CHECK(batch.has_filter(1, f1));
+    CHECK(batch.has_filter(1, f70));
+    CHECK(batch.get_filters(1)[0] == ~uint64_t(1));
+    CHECK(batch.get_filters(1)[1] == 0x7F);
+}
+
+TEST_CASE("QUAL as a float")
+{
+    static const char vcf[] = R"(##fileformat=VCFv4.0
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO
+1	100	.	C	G	50.5	.	.
+1	200	.	C	G	.	.	.
+1	300	.	C	G	1e3	.	.
+1	400	.	C	G	high	.	.
+1	500	.	C	G	-0.25	.	.)";
+
+    run_test_case_with_and_without_cr(vcf,
+            {
+                    {"^", ""},
+                    {"QF", "Q:50.5"},
+                    {";", ";"},
+                    {"QF", "Q:."},
+                    {";", ";"},
+                    {"QF", "Q:1000"},
+                    {";", ";"},
+                    {"QF", "E:Invalid floating-point value in the QUAL column"},
+                    {"QF", "Q:-0.25"},
+                    {";", ";"},
+                    {".", ""},
+            });
+
+    VCF_scanner vcf_scanner;
+    VCF_reader vcf_reader(vcf, sizeof(vcf) - 1);
+    VCF_header header;
+    VCF_record record;
+
+    std::stringstream dump;
+    REQUIRE(update_dump(dump, vcf_scanner, vcf_reader,
+            vcf_scanner.parse_header(&header)));
+
+    std::vector<float> qualities;
+    while (!vcf_scanner.at_eof()) {
+        REQUIRE(update_dump(dump, vcf_scanner, vcf_reader,
+                vcf_scanner.parse_record(&record)));
+        float quality;
+        if (record.get_quality(&quality)) {
+            qualities.push_back(quality);
+        }
+        REQUIRE(update_dump(dump, vcf_scanner, vcf_reader,
+                vcf_scanner.clear_line()));
+    }
+
+    REQUIRE(qualities.size() == 4);
+    CHECK(qualities[0] == 50.5f);
+    CHECK(std::isnan(qualities[1]));
+    CHECK(qualities[2] == 1000.0f);
+    CHECK(qualities[3] == -0.25f);
+}
+
+TEST_CASE("Contig IDs")
+{
+    run_test_case_with_and_without_cr(R"(##fileformat=VCFv4.0
+##contig=<ID=1,length=1000>
+##contig=<ID=2>
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO
+2	100	.	C	G	.	.	.
+2	200	.	C	G	.	.	.
+MT	300	.	C	G	.	.	.
+1	400	.	C	G	.	.	.
+MT	500	.	C	G	.	.	.
+Y	x	.	C	G	.	.	.
+X	600	.	C	G	.	.	.)",
+            {
+                    {"^", ""},
+                    {"K", "K:1=2@100"},
+                    {";", ";"},
+                    {"K", "K:1=2@200"},
+                    {";", ";"},
+                    {"K", "K:2=MT@300"},
+                    {";", ";"},
+                    {"L", "L:1@400"},
+                    {";", ";"},
+                    {"K", "K:2=MT@500"},
+                    {";", ";"},
+                    {"K", "E:Missing an integer in the POS column"},
+                    {"B9", "B:[X@600|.|C|G|.||.]"},
+                    {".", ""},
+            });
+}
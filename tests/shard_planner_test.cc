@@ -0,0 +1,256 @@
+#include <vcf_scanner/vcf_parallel.hh>
+
+#include "catch.hh"
+
+static const std::string test_vcf = R"(##fileformat=VCFv4.0
+##contig=<ID=1,length=1000>
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO	FORMAT	S1	S2
+1	100	.	C	G	.	.	.	GT	0|1	1/.
+1	200	.	C	G	.	.	.	GT	0|0	0|0
+1	300	.	C	G,T	.	.	.	GT	1|2	0/0
+1	400	rs400;rs401	C	T	.	.	.	GT	0|1	1/1
+1	500	.	C	G	.	.	.	GT	0|1	0/1
+)";
+
+TEST_CASE("Header parsing and data offset")
+{
+    VCF_memory_input input(test_vcf.data(), test_vcf.length());
+    VCF_shard_planner planner(input);
+
+    VCF_header header;
+    REQUIRE(planner.parse_header(&header) == VCF_parsing_event::ok);
+
+    CHECK(header.get_sample_ids() == std::vector<std::string>({"S1", "S2"}));
+    CHECK(planner.get_data_offset() == test_vcf.find("\n1\t") + 1);
+}
+
+static std::vector<unsigned> collect_positions(const VCF_input& input,
+        const VCF_header& header, const VCF_byte_range& range)
+{
+    std::vector<unsigned> positions;
+
+    VCF_scanner scanner;
+    VCF_range_feeder feeder(input, range, 7);
+
+    auto parse_to_completion = [&](VCF_parsing_event pe) {
+        while (pe == VCF_parsing_event::need_more_data) {
+            pe = feeder.read_and_feed(scanner);
+        }
+        REQUIRE(pe == VCF_parsing_event::ok);
+    };
+
+    parse_to_completion(scanner.start_at_data_line(header));
+
+    std::string chrom;
+    unsigned pos;
+    while (!scanner.at_eof()) {
+        parse_to_completion(scanner.parse_loc(&chrom, &pos));
+        positions.push_back(pos);
+        parse_to_completion(scanner.clear_line());
+    }
+
+    return positions;
+}
+
+TEST_CASE("Shards are line-aligned and cover all data lines")
+{
+    VCF_memory_input input(test_vcf.data(), test_vcf.length());
+    VCF_shard_planner planner(input);
+
+    VCF_header header;
+    REQUIRE(planner.parse_header(&header) == VCF_parsing_event::ok);
+
+    for (unsigned number_of_shards = 1; number_of_shards <= 12;
+            ++number_of_shards) {
+        std::vector<VCF_byte_range> shards;
+        REQUIRE(planner.plan_shards(number_of_shards, &shards));
+        REQUIRE(shards.size() == number_of_shards);
+
+        CHECK(shards.front().begin == planner.get_data_offset());
+        CHECK(shards.back().end == test_vcf.length());
+
+        std::vector<unsigned> positions;
+        for (size_t i = 0; i < shards.size(); ++i) {
+            if (i > 0) {
+                CHECK(shards[i].begin == shards[i - 1].end);
+            }
+            if (shards[i].begin < shards[i].end) {
+                CHECK(test_vcf[shards[i].begin - 1] == '\n');
+            }
+            for (unsigned pos : collect_positions(input, header, shards[i])) {
+                positions.push_back(pos);
+            }
+        }
+        CHECK(positions ==
+                std::vector<unsigned>({100, 200, 300, 400, 500}));
+    }
+}
+
+TEST_CASE("Parallel range scanning")
+{
+    VCF_memory_input input(test_vcf.data(), test_vcf.length());
+    VCF_shard_planner planner(input);
+
+    VCF_header header;
+    REQUIRE(planner.parse_header(&header) == VCF_parsing_event::ok);
+
+    std::vector<VCF_byte_range> shards;
+    REQUIRE(planner.plan_shards(3, &shards));
+
+    VCF_thread_pool thread_pool(2);
+    VCF_range_scheduler scheduler(thread_pool, 16);
+
+    for (const auto& shard : shards) {
+        scheduler.add_job(input, header, shard);
+    }
+    REQUIRE(scheduler.get_number_of_jobs() == 3);
+
+    std::vector<unsigned> genotype_counts(scheduler.get_number_of_jobs());
+
+    scheduler.run([&](size_t job_index, VCF_scanner& scanner,
+                          VCF_range_feeder& feeder) {
+        auto parse_to_completion = [&](VCF_parsing_event pe) {
+            while (pe == VCF_parsing_event::need_more_data) {
+                pe = feeder.read_and_feed(scanner);
+            }
+            return pe == VCF_parsing_event::ok;
+        };
+
+        while (!scanner.at_eof()) {
+            if (parse_to_completion(scanner.parse_genotype_format()) &&
+                    scanner.capture_gt()) {
+                while (scanner.genotype_available() &&
+                        parse_to_completion(scanner.parse_genotype())) {
+                    ++genotype_counts[job_index];
+                }
+            }
+            parse_to_completion(scanner.clear_line());
+        }
+    });
+
+    unsigned total = 0;
+    for (size_t i = 0; i < shards.size(); ++i) {
+        CHECK(scheduler.get_job_error(i).empty());
+        total += genotype_counts[i];
+    }
+    CHECK(total == 10);
+}
+
+static std::string make_multi_contig_vcf()
+{
+    std::string vcf = R"(##fileformat=VCFv4.2
+##contig=<ID=chr1,length=248956422,assembly="GRCh38, primary">
+##contig=<ID=chr2,length=242193529>
+##contig=<ID=decoy>
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO
+)";
+    static const struct {
+        const char* chrom;
+        unsigned number_of_lines;
+    } contigs[] = {{"chr1", 500}, {"chr2", 37}, {"chrX", 1}, {"chrY", 2},
+            {"decoy", 1}};
+
+    for (const auto& contig : contigs) {
+        for (unsigned i = 1; i <= contig.number_of_lines; ++i) {
+            vcf += contig.chrom;
+            vcf += '\t' + std::to_string(i * 10) + "\t.\tA\tC\t.\t.\t.\n";
+        }
+    }
+    return vcf;
+}
+
+TEST_CASE("Contig declarations")
+{
+    const std::string vcf = make_multi_contig_vcf();
+    VCF_memory_input input(vcf.data(), vcf.length());
+    VCF_shard_planner planner(input);
+
+    VCF_header header;
+    REQUIRE(planner.parse_header(&header) == VCF_parsing_event::ok);
+
+    const auto& contigs = header.get_contigs();
+    REQUIRE(contigs.size() == 3);
+    CHECK(contigs[0].id == "chr1");
+    CHECK(contigs[0].length == 248956422);
+    CHECK(contigs[1].id == "chr2");
+    CHECK(contigs[1].length == 242193529);
+    CHECK(contigs[2].id == "decoy");
+    CHECK(contigs[2].length == 0);
+}
+
+TEST_CASE("Per-contig ranges")
+{
+    const std::string vcf = make_multi_contig_vcf();
+    VCF_memory_input input(vcf.data(), vcf.length());
+    VCF_shard_planner planner(input);
+
+    VCF_header header;
+    REQUIRE(planner.parse_header(&header) == VCF_parsing_event::ok);
+
+    std::vector<VCF_contig_range> contig_ranges;
+    REQUIRE(planner.plan_contigs(&contig_ranges));
+    REQUIRE(contig_ranges.size() == 5);
+
+    static const char* const expected_contigs[] = {
+            "chr1", "chr2", "chrX", "chrY", "decoy"};
+    for (size_t i = 0; i < contig_ranges.size(); ++i) {
+        CHECK(contig_ranges[i].contig == expected_contigs[i]);
+        CHECK(vcf.compare(contig_ranges[i].range.begin,
+                      contig_ranges[i].contig.length() + 1,
+                      contig_ranges[i].contig + '\t') == 0);
+    }
+    CHECK(contig_ranges.front().range.begin == planner.get_data_offset());
+    CHECK(contig_ranges.back().range.end == vcf.length());
+
+    VCF_thread_pool thread_pool(3);
+    VCF_range_scheduler scheduler(thread_pool);
+
+    for (const auto& contig_range : contig_ranges) {
+        scheduler.add_job(input, header, contig_range.range);
+    }
+
+    std::vector<std::vector<std::string>> chroms(contig_ranges.size());
+
+    scheduler.run([&](size_t job_index, VCF_scanner& scanner,
+                          VCF_range_feeder& feeder) {
+        std::string chrom;
+        unsigned pos;
+        while (!scanner.at_eof()) {
+            VCF_parsing_event pe = scanner.parse_loc(&chrom, &pos);
+            while (pe == VCF_parsing_event::need_more_data) {
+                pe = feeder.read_and_feed(scanner);
+            }
+            chroms[job_index].push_back(chrom);
+            pe = scanner.clear_line();
+            while (pe == VCF_parsing_event::need_more_data) {
+                pe = feeder.read_and_feed(scanner);
+            }
+        }
+    });
+
+    CHECK(chroms[0] == std::vector<std::string>(500, "chr1"));
+    CHECK(chroms[1] == std::vector<std::string>(37, "chr2"));
+    CHECK(chroms[2] == std::vector<std::string>(1, "chrX"));
+    CHECK(chroms[3] == std::vector<std::string>(2, "chrY"));
+    CHECK(chroms[4] == std::vector<std::string>(1, "decoy"));
+}
+
+TEST_CASE("Interleaved contigs")
+{
+    const std::string vcf = R"(##fileformat=VCFv4.2
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO
+1	1	.	A	C	.	.	.
+2	1	.	A	C	.	.	.
+2	2	.	A	C	.	.	.
+1	2	.	A	C	.	.	.
+)";
+    VCF_memory_input input(vcf.data(), vcf.length());
+    VCF_shard_planner planner(input);
+
+    VCF_header header;
+    REQUIRE(planner.parse_header(&header) == VCF_parsing_event::ok);
+
+    std::vector<VCF_contig_range> contig_ranges;
+    CHECK(!planner.plan_contigs(&contig_ranges));
+    CHECK(planner.get_error() == "Data lines of contig '1' are not adjacent");
+}
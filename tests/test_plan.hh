@@ -6,6 +6,7 @@
 #include "catch.hh"
 
 #include <sstream>
+#include <cmath>
 
 namespace {
 
@@ -124,6 +125,19 @@ void dump_list(std::stringstream& dump, const T& list)
     dump << ']';
 }
 
+// Dumps the IDs in the set as "ID=name" pairs.
+void dump_id_set(std::stringstream& dump, const VCF_id_set& id_set,
+        const std::vector<std::string>& names)
+{
+    std::vector<std::string> list;
+    for (unsigned id = 0; id < names.size(); ++id) {
+        if (id_set.contains(id)) {
+            list.push_back(std::to_string(id) + '=' + names[id]);
+        }
+    }
+    dump_list(dump, list);
+}
+
 void dump_header(std::stringstream& dump, const VCF_header& vcf_header,
         const char* test_plan)
 {
@@ -176,22 +190,193 @@ const char* dump_genotype(std::stringstream& dump, VCF_scanner& vcf_scanner,
     case 'A':
         ++test_plan;
         dump << (vcf_scanner.genotype_available() ? "GT:AVAIL" : "GT:NO MORE");
+        break;
+    case 'P':
+        // The number of samples follows the instruction.
+        {
+            const unsigned number_of_samples = (unsigned) (test_plan[1] - '0');
+            test_plan += 2;
+            uint8_t packed[3];
+            if (dump_issues_and_clear_line(dump, vcf_scanner, vcf_reader,
+                        vcf_scanner.parse_packed_gt_row(packed))) {
+                std::vector<unsigned> codes;
+                for (unsigned i = 0; i < number_of_samples; ++i) {
+                    codes.push_back((packed[i / 4] >> (i % 4 * 2)) & 3);
+                }
+                dump << "GP:";
+                dump_list(dump, codes);
+            }
+        }
+        break;
+    case 'S':
+        ++test_plan;
+        {
+            VCF_sparse_gt_row row;
+            if (dump_issues_and_clear_line(dump, vcf_scanner, vcf_reader,
+                        vcf_scanner.parse_sparse_gt_row(&row))) {
+                std::vector<std::string> genotypes;
+                for (size_t i = 0; i < row.samples.size(); ++i) {
+                    std::string genotype = std::to_string(row.samples[i]) + '=';
+                    for (unsigned j = 0; j < row.ploidy; ++j) {
+                        const int allele = row.alleles[i * row.ploidy + j];
+                        if (allele == VCF_gt_vector_end) {
+                            break;
+                        }
+                        if (j > 0) {
+                            genotype += row.phased[i] ? '|' : '/';
+                        }
+                        genotype += allele == VCF_gt_missing ?
+                                std::string(".") :
+                                std::to_string(allele);
+                    }
+                    genotypes.push_back(genotype);
+                }
+                dump << "GS:";
+                dump_list(dump, genotypes);
+            }
+        }
+        break;
+    case 'E':
+        // The genotype class ('c' for carrier, 'h' for het, or 'a' for
+        // hom_alt) and the minimum number of samples follow "GE".
+        {
+            VCF_gt_predicate predicate;
+            predicate.genotype_class = test_plan[1] == 'c' ?
+                    VCF_gt_predicate::carrier :
+                    test_plan[1] == 'h' ? VCF_gt_predicate::het :
+                                          VCF_gt_predicate::hom_alt;
+            predicate.min_samples = (unsigned) (test_plan[2] - '0');
+            test_plan += 3;
+            bool result;
+            if (dump_issues_and_clear_line(dump, vcf_scanner, vcf_reader,
+                        vcf_scanner.evaluate_gt_predicate(
+                                predicate, &result))) {
+                dump << "GE:" << (result ? "true" : "false");
+            }
+        }
+        break;
+    case 'D':
+    case 'X':
+        // "GD" decodes float dosages, and "GX" decodes fixed-point
+        // dosages. The number of samples, the number of values per
+        // sample, and the key follow the instruction.
+        {
+            const bool fixed = *test_plan == 'X';
+            const unsigned number_of_samples = (unsigned) (test_plan[1] - '0');
+            const unsigned values_per_sample = (unsigned) (test_plan[2] - '0');
+            const char* key = test_plan + 3;
+            test_plan += strlen(test_plan);
+            const unsigned size = number_of_samples * values_per_sample;
+            std::vector<float> dosages(size);
+            std::vector<uint16_t> fixed_dosages(size);
+            if (dump_issues_and_clear_line(dump, vcf_scanner, vcf_reader,
+                        fixed ? vcf_scanner.parse_dosage_row(key,
+                                        fixed_dosages.data(),
+                                        values_per_sample) :
+                                vcf_scanner.parse_dosage_row(key,
+                                        dosages.data(), values_per_sample))) {
+                std::vector<std::string> values;
+                for (unsigned i = 0; i < size; ++i) {
+                    if (fixed) {
+                        values.push_back(std::to_string(fixed_dosages[i]));
+                    } else if (std::isnan(dosages[i])) {
+                        values.push_back(".");
+                    } else {
+                        std::stringstream value;
+                        value << dosages[i];
+                        values.push_back(value.str());
+                    }
+                }
+                dump << key << ':';
+                dump_list(dump, values);
+            }
+        }
     }
     return test_plan;
 }
 
+// Dumps the fields of a record in the format of the
+// respective instructions. INFO is accessed first.
+void dump_record(std::stringstream& dump, VCF_record& record)
+{
+    dump << "I:";
+    dump_list(dump, record.get_info());
+    dump << ";L:" << record.get_chrom() << '@';
+    unsigned pos;
+    if (record.get_pos(&pos)) {
+        dump << pos;
+    } else {
+        dump << '?';
+    }
+    dump << ";ID:";
+    dump_list(dump, record.get_ids());
+    dump << ";R:" << record.get_ref() << ";A:";
+    dump_list(dump, record.get_alts());
+    dump << ";Q:" << record.get_quality() << ";F:";
+    dump_list(dump, record.get_filters());
+}
+
+// Dumps each record of a batch as
+// "chrom@pos|ids|ref|alts|quality|filters|info".
+void dump_batch(std::stringstream& dump, const VCF_scanner& vcf_scanner,
+        const VCF_record_batch& batch)
+{
+    dump << "B:[";
+    for (size_t i = 0; i < batch.get_number_of_records(); ++i) {
+        if (i > 0) {
+            dump << ' ';
+        }
+        size_t len;
+        const char* text;
+        dump << vcf_scanner.get_contig_names().at(batch.get_chrom_ids()[i])
+             << '@'
+             << batch.get_positions()[i] << '|';
+        text = batch.get_ids(i, &len);
+        dump << std::string(text, len) << '|';
+        text = batch.get_ref(i, &len);
+        dump << std::string(text, len) << '|';
+        text = batch.get_alts(i, &len);
+        dump << std::string(text, len) << '|';
+        if (batch.get_qualities()[i] != batch.get_qualities()[i]) {
+            dump << '.';
+        } else {
+            dump << batch.get_qualities()[i];
+        }
+        dump << '|';
+        const std::vector<std::string>& filter_names =
+                vcf_scanner.get_filter_names();
+        const char* separator = "";
+        for (unsigned filter_id = 0; filter_id < filter_names.size();
+                ++filter_id) {
+            if (batch.has_filter(i, filter_id)) {
+                dump << separator << filter_names[filter_id];
+                separator = ";";
+            }
+        }
+        text = batch.get_info(i, &len);
+        dump << '|' << std::string(text, len);
+    }
+    dump << ']';
+}
+
 void ineterpret_test_plan(const std::vector<Test_check>& test_plan,
         VCF_scanner& vcf_scanner, VCF_reader& vcf_reader)
 {
     VCF_header header;
 
     std::string chrom;
+    unsigned contig_id;
     unsigned pos;
     std::vector<std::string> ids;
     std::string ref;
     std::vector<std::string> alts;
     std::string quality_str;
+    float quality;
     std::vector<std::string> filters;
+    VCF_id_set filter_ids;
+    VCF_id_set info_flags;
+    VCF_record record;
+    VCF_record_batch batch;
 
     for (const auto& test_check : test_plan) {
         std::stringstream dump;
@@ -218,6 +403,14 @@ void ineterpret_test_plan(const std::vector<Test_check>& test_plan,
                 dump << "L:" << chrom << '@' << pos;
             }
             break;
+        case 'K':
+            if (dump_issues_and_clear_line(dump, vcf_scanner, vcf_reader,
+                        vcf_scanner.parse_loc(&contig_id, &pos))) {
+                dump << "K:" << contig_id << '='
+                     << vcf_scanner.get_contig_names().at(contig_id) << '@'
+                     << pos;
+            }
+            break;
         case '#':
             if (dump_issues_and_clear_line(dump, vcf_scanner, vcf_reader,
                         vcf_scanner.parse_ids(&ids))) {
@@ -233,8 +426,20 @@ void ineterpret_test_plan(const std::vector<Test_check>& test_plan,
             }
             break;
         case 'Q':
-            if (dump_issues_and_clear_line(dump, vcf_scanner, vcf_reader,
-                        vcf_scanner.parse_quality(&quality_str))) {
+            // "QF" parses QUAL as a float.
+            if (test_check.instructions[1] == 'F') {
+                if (dump_issues_and_clear_line(dump, vcf_scanner,
+                            vcf_reader, vcf_scanner.parse_quality(&quality))) {
+                    dump << "Q:";
+                    if (std::isnan(quality)) {
+                        dump << '.';
+                    } else {
+                        dump << quality;
+                    }
+                }
+            } else if (dump_issues_and_clear_line(dump, vcf_scanner,
+                               vcf_reader,
+                               vcf_scanner.parse_quality(&quality_str))) {
                 dump << "Q:" << quality_str;
             }
             break;
@@ -245,6 +450,27 @@ void ineterpret_test_plan(const std::vector<Test_check>& test_plan,
                 dump_list(dump, filters);
             }
             break;
+        case 'P':
+            if (dump_issues_and_clear_line(dump, vcf_scanner, vcf_reader,
+                        vcf_scanner.parse_filters(&filter_ids))) {
+                dump << "P:";
+                dump_id_set(
+                        dump, filter_ids, vcf_scanner.get_filter_names());
+            }
+            break;
+        case 'J':
+            // "JC" uses parse_captured_info() instead of parse_info().
+            vcf_scanner.capture_info_flags(&info_flags);
+            if (dump_issues_and_clear_line(dump, vcf_scanner, vcf_reader,
+                        test_check.instructions[1] == 'C' ?
+                                vcf_scanner.parse_captured_info() :
+                                vcf_scanner.parse_info())) {
+                dump << "J:";
+                dump_id_set(
+                        dump, info_flags, vcf_scanner.get_info_flag_names());
+            }
+            vcf_scanner.capture_info_flags(nullptr);
+            break;
         case 'I':
             if (dump_issues_and_clear_line(dump, vcf_scanner, vcf_reader,
                         vcf_scanner.parse_info())) {
@@ -252,6 +478,21 @@ void ineterpret_test_plan(const std::vector<Test_check>& test_plan,
                 dump_list(dump, vcf_scanner.get_info());
             }
             break;
+        case 'R':
+            if (dump_issues_and_clear_line(dump, vcf_scanner, vcf_reader,
+                        vcf_scanner.parse_record(&record))) {
+                dump_record(dump, record);
+            }
+            break;
+        case 'B':
+            // The digit that follows is the maximum batch size.
+            // Records that precede a malformed line are dumped
+            // after the error.
+            dump_issues_and_clear_line(dump, vcf_scanner, vcf_reader,
+                    vcf_scanner.parse_batch(&batch,
+                            (size_t) (test_check.instructions[1] - '0')));
+            dump_batch(dump, vcf_scanner, batch);
+            break;
         case 'G':
             dump_genotype(
                     dump, vcf_scanner, vcf_reader, test_check.instructions + 1);
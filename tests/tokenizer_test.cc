@@ -256,3 +256,74 @@ TEST_CASE("Simple checks")
     REQUIRE(tokenizer.prepare_token_or_accumulate(tokenizer.find_newline()));
     CHECK(tokenizer.at_eol());
 }
+
+TEST_CASE("Skipping tab-terminated tokens")
+{
+    VCF_tokenizer tokenizer;
+
+    static const char test_data[] =
+            "a\tbb\t\t\tccc\tdddddddddd\t0/0\t0/1\t1/1\t\t\t\t\t\t\t\t\tx\n"
+            "y\tz\n";
+    tokenizer.set_new_buffer(test_data, sizeof(test_data) - 1);
+
+    unsigned number_of_tabs = 1;
+    REQUIRE(tokenizer.skip_tabs(&number_of_tabs));
+    CHECK(number_of_tabs == 0);
+    CHECK(tokenizer.get_terminator() == '\t');
+
+    // Nine tokens, some of which are longer than eight bytes.
+    number_of_tabs = 9;
+    REQUIRE(tokenizer.skip_tabs(&number_of_tabs));
+    CHECK(tokenizer.get_terminator() == '\t');
+    REQUIRE(tokenizer.prepare_token_or_accumulate(
+            tokenizer.find_newline_or_tab()));
+    CHECK(tokenizer.get_token() == "");
+
+    // The newline stops skipping.
+    number_of_tabs = 100;
+    REQUIRE(tokenizer.skip_tabs(&number_of_tabs));
+    CHECK(number_of_tabs == 94);
+    CHECK(tokenizer.at_eol());
+    CHECK(tokenizer.get_line_number() == 2);
+
+    // Skipping that spans buffers.
+    const std::string data(test_data);
+    for (size_t chunk_size = 1; chunk_size <= data.length(); ++chunk_size) {
+        tokenizer.set_new_buffer(data.data(), chunk_size);
+        size_t offset = chunk_size;
+        auto feed_next_chunk = [&] {
+            const size_t size = std::min(chunk_size, data.length() - offset);
+            tokenizer.set_new_buffer(data.data() + offset, size);
+            offset += size;
+        };
+        number_of_tabs = 7;
+        while (!tokenizer.skip_tabs(&number_of_tabs)) {
+            feed_next_chunk();
+        }
+        REQUIRE(number_of_tabs == 0);
+        while (!tokenizer.prepare_token_or_accumulate(
+                tokenizer.find_newline_or_tab())) {
+            feed_next_chunk();
+        }
+        CHECK(tokenizer.get_token() == "0/1");
+    }
+
+    std::vector<size_t> offsets;
+    VCF_tokenizer::find_tabs(test_data, sizeof(test_data) - 1, &offsets);
+    REQUIRE(offsets.size() == 18);
+    CHECK(offsets[0] == 1);
+    CHECK(offsets[4] == 10);
+    CHECK(offsets[5] == 21);
+    CHECK(offsets[16] == 41);
+    CHECK(offsets[17] == 45);
+
+    // The last token of the input ends at EOF.
+    static const char last_line[] = "a\tb";
+    tokenizer.set_new_buffer(last_line, sizeof(last_line) - 1);
+    number_of_tabs = 5;
+    REQUIRE(!tokenizer.skip_tabs(&number_of_tabs));
+    CHECK(number_of_tabs == 4);
+    tokenizer.set_new_buffer(nullptr, 0);
+    REQUIRE(tokenizer.skip_tabs(&number_of_tabs));
+    CHECK(tokenizer.at_eol());
+}